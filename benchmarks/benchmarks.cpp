@@ -0,0 +1,432 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Micro-benchmarks of components of the tracker
+ *
+ * Every benchmark runs an operation repeatedly on synthetic data until the minimal time elapses and reports
+ * time of one operation. No video files are needed and random data are generated with fixed seeds, so runs
+ * of different builds can be compared. Results are printed as a table and written as JSON.
+ *
+ * Usage: benchmarks [--json FILE] [--filter TEXT] [--min-time SECONDS]
+ */
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <memory>
+#include <complex>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+#include <opencv2/core/core.hpp>
+
+#include "../modules/Map.hpp"
+#include "../modules/ModifiedKalmanFilter.hpp"
+#include "../modules/KalmanEngine.hpp"
+#include "../modules/MultipleTracker.hpp"
+#include "../modules/TrackingContext.hpp"
+#include "../modules/TrackerCore.hpp"
+
+namespace
+{
+    //! Result of one benchmark
+    struct BenchmarkResult
+    {
+        std::string Name, Parameters;
+        unsigned long Operations;
+        double NanosecondsPerOperation;
+    };
+
+    //! Settings from the command line
+    struct BenchmarkOptions
+    {
+        std::string Filter;
+        double MinTime;
+    };
+
+    typedef std::chrono::steady_clock Clock;
+
+    /*!
+     * \brief Call aFunction until aOptions.MinTime elapses, every call performs aOperationsPerCall operations
+     *
+     * First call is a warm-up and it is not measured. Benchmarks filtered out by name are skipped.
+     */
+    template<typename Function>
+    void Measure(const BenchmarkOptions &aOptions, std::vector<BenchmarkResult> &aResults, const std::string &aName,
+                 const std::string &aParameters, unsigned long aOperationsPerCall, Function aFunction)
+    {
+        if(!aOptions.Filter.empty() && (aName + " " + aParameters).find(aOptions.Filter) == std::string::npos)
+            return;
+
+        aFunction();
+
+        unsigned long calls = 0;
+        double elapsed = 0;
+        const Clock::time_point start = Clock::now();
+        while(elapsed < aOptions.MinTime)
+        {
+            aFunction();
+            ++calls;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        }
+
+        BenchmarkResult result{aName, aParameters, calls*aOperationsPerCall, elapsed*1e9/(calls*aOperationsPerCall)};
+        std::cout << std::left << std::setw(34) << result.Name << std::setw(36) << result.Parameters << std::right
+                  << std::setw(14) << std::fixed << std::setprecision(1) << result.NanosecondsPerOperation << " ns"
+                  << std::setw(12) << result.Operations << std::endl;
+        aResults.push_back(result);
+    }
+
+    //! Random velocity vector at random position of the frame
+    struct Movement
+    {
+        unsigned int X, Y;
+        double DeltaX, DeltaY, Angle;
+    };
+
+    std::vector<Movement> RandomMovements(unsigned int aWidth, unsigned int aHeight, size_t aCount)
+    {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<unsigned int> x_position(0, aWidth - 1), y_position(0, aHeight - 1);
+        std::normal_distribution<double> velocity(0.0, 8.0);
+        std::vector<Movement> movements(aCount);
+        for(Movement &movement : movements)
+        {
+            movement.X = x_position(generator);
+            movement.Y = y_position(generator);
+            movement.DeltaX = velocity(generator);
+            movement.DeltaY = velocity(generator);
+            movement.Angle = Map::CalcAngle(movement.DeltaY, movement.DeltaX);
+        }
+        return movements;
+    }
+
+    const char *EncodingName(MapCellEncoding aEncoding)
+    {
+        switch(aEncoding)
+        {
+            case E_float_cell: return "float";
+            case E_fixed16_cell: return "fixed16";
+            default: return "double";
+        }
+    }
+
+    void BenchmarkMap(const BenchmarkOptions &aOptions, std::vector<BenchmarkResult> &aResults)
+    {
+        const cv::Size resolutions[3] = {cv::Size(640, 480), cv::Size(1920, 1080), cv::Size(3840, 2160)};
+        const MapCellEncoding encodings[2] = {E_double_cell, E_fixed16_cell};
+        const size_t batch = 4096;
+
+        for(const cv::Size &resolution : resolutions)
+        {
+            const std::vector<Movement> movements = RandomMovements(resolution.width, resolution.height, batch);
+            for(MapCellEncoding encoding : encodings)
+            {
+                std::ostringstream parameters;
+                parameters << resolution.width << "x" << resolution.height << " " << EncodingName(encoding);
+
+                //Layout used by VideoProcessor for the encoding
+                Map map(resolution.height, resolution.width, 10,
+                        encoding == E_fixed16_cell ? E_cell_major : E_direction_major, encoding);
+                Measure(aOptions, aResults, "Map::SetVelocityVector", parameters.str(), batch, [&map, &movements]
+                {
+                    for(const Movement &movement : movements)
+                        map.SetVelocityVector(movement.X, movement.Y, movement.DeltaX, movement.DeltaY, movement.Angle);
+                });
+
+                double sink = 0;
+                Measure(aOptions, aResults, "Map::GetVelocitVector", parameters.str(), batch, [&map, &movements, &sink]
+                {
+                    for(const Movement &movement : movements)
+                        sink += std::abs(map.GetVelocitVector(movement.X, movement.Y, movement.Angle));
+                });
+                if(sink < 0)
+                    std::cout << sink << std::endl;     //Result is used, so the loop is not removed
+            }
+        }
+
+        //Saving and loading of a fully written map
+        const char *file_name = "benchmark_map.tmp";
+        for(int i = 0; i < 2; ++i)
+        {
+            const cv::Size &resolution = resolutions[i];
+            std::ostringstream parameters;
+            parameters << resolution.width << "x" << resolution.height << " double";
+
+            Map map(resolution.height, resolution.width, 10);
+            for(const Movement &movement : RandomMovements(resolution.width, resolution.height, 1 << 18))
+                map.SetVelocityVector(movement.X, movement.Y, movement.DeltaX, movement.DeltaY, movement.Angle);
+            map.SetFileName(file_name);
+            Measure(aOptions, aResults, "Map::SaveMap", parameters.str(), 1, [&map]{ map.SaveMap(); });
+
+            //File is written even if saving is filtered out
+            map.SaveMap();
+            Map loaded_map(resolution.height, resolution.width, 10);
+            loaded_map.SetFileName(file_name);
+            Measure(aOptions, aResults, "Map::LoadMap", parameters.str(), 1, [&loaded_map]{ loaded_map.LoadMap(); });
+        }
+        std::remove(file_name);
+    }
+
+    template<enum KalmanFilterType ModelType>
+    void BenchmarkKalmanFilter(const BenchmarkOptions &aOptions, std::vector<BenchmarkResult> &aResults,
+                               const std::string &aModel)
+    {
+        const unsigned long steps = 1000;
+
+        ModifiedKalmanFilter<ModelType> predicted_filter;
+        predicted_filter.SetInitialPosition(cv::Point(100, 100));
+        Measure(aOptions, aResults, "ModifiedKalmanFilter::Predict", aModel, steps, [&predicted_filter]
+        {
+            for(unsigned long i = 0; i < steps; ++i)
+                predicted_filter.Predict(0);
+        });
+
+        //Object moves along a line, so the state stays in a realistic range
+        ModifiedKalmanFilter<ModelType> filter;
+        filter.SetInitialPosition(cv::Point(100, 100));
+        int position = 0;
+        Measure(aOptions, aResults, "ModifiedKalmanFilter::Correct", aModel + " with predict", steps, [&filter, &position]
+        {
+            for(unsigned long i = 0; i < steps; ++i)
+            {
+                filter.Predict(0);
+                position = (position + 3) % 2000;
+                filter.Correct(cv::Point(100 + position, 100 + position/2));
+            }
+        });
+
+        //Batched filters of all tracks as used by TrackingContext, every track is measured in every frame
+        typedef KalmanModel<ModelType> Model;
+        const size_t track_count = 500;
+        KalmanEngine<Model::StateSize> engine(Model::TimeStep, Model::ProcessNoise, Model::MeasurementNoise,
+                                              Model::ErrorCovariance);
+        std::vector<size_t> slots(track_count);
+        for(size_t i = 0; i < track_count; ++i)
+        {
+            slots[i] = engine.AddTrack();
+            engine.SetPosition(slots[i], float(100 + i), float(100 + i/2));
+        }
+
+        std::ostringstream parameters;
+        parameters << aModel << " x" << track_count;
+        Measure(aOptions, aResults, "KalmanEngine::PredictAll", parameters.str(), track_count, [&engine]
+        {
+            engine.PredictAll();
+        });
+
+        int frame = 0;
+        Measure(aOptions, aResults, "KalmanEngine::CorrectAll", parameters.str() + " with predict", track_count,
+                [&engine, &slots, &frame]
+        {
+            engine.PredictAll();
+            frame = (frame + 3) % 2000;
+            for(size_t i = 0; i < slots.size(); ++i)
+                engine.SetMeasurement(slots[i], float(100 + i + frame), float(100 + i/2 + frame/2));
+            engine.CorrectAll();
+        });
+    }
+
+    void BenchmarkMultipleTracker(const BenchmarkOptions &aOptions, std::vector<BenchmarkResult> &aResults)
+    {
+        const MultipleTrackerType types[2] = {E_singleKalman_singleMap, E_doubleKalman_singleMap};
+        const char *type_names[2] = {"single Kalman", "double Kalman"};
+        const int tracker_count = 100;
+
+        std::shared_ptr<Map> map = std::make_shared<Map>(1080, 1920, 10);
+        for(const Movement &movement : RandomMovements(1920, 1080, 1 << 16))
+            map->SetVelocityVector(movement.X, movement.Y, movement.DeltaX, movement.DeltaY, movement.Angle);
+
+        for(int type = 0; type < 2; ++type)
+        {
+            TrackingContext context;
+            context.SetMap(map);
+            std::vector<std::unique_ptr<MultipleTracker>> trackers;
+            for(int i = 0; i < tracker_count; ++i)
+            {
+                trackers.emplace_back(new MultipleTracker(types[type], context));
+                trackers.back()->SetInitialPosition(cv::Point(100 + 17*i, 100 + 9*i));
+            }
+
+            //One frame: prediction of all trackers, their fan-out to the trackers inside and correction
+            int frame = 0;
+            std::ostringstream parameters;
+            parameters << type_names[type] << " x" << tracker_count;
+            Measure(aOptions, aResults, "MultipleTracker::Predict+Correct", parameters.str(), tracker_count,
+                    [&context, &trackers, &frame]
+            {
+                ++frame;
+                context.PredictAll();
+                for(size_t i = 0; i < trackers.size(); ++i)
+                {
+                    trackers[i]->Predict(45.0);
+                    trackers[i]->Correct(cv::Point(100 + 17*int(i) + frame % 500, 100 + 9*int(i) + frame % 300));
+                }
+                context.CorrectAll();
+            });
+        }
+    }
+
+    //! Rectangles of moving objects in every frame, objects close to each other merge into one blob
+    std::vector<std::vector<cv::Rect>> SyntheticDetections(int aObjects, int aFrames, const cv::Size &aArea)
+    {
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<double> uniform(0, 1);
+        struct SyntheticObject { double X, Y, VelocityX, VelocityY; };
+        std::vector<SyntheticObject> objects(aObjects);
+        for(SyntheticObject &object : objects)
+        {
+            object = SyntheticObject{100 + uniform(generator)*(aArea.width - 200), 100 + uniform(generator)*(aArea.height - 200),
+                                     uniform(generator)*6 - 3, uniform(generator)*6 - 3};
+        }
+
+        std::vector<std::vector<cv::Rect>> frames(aFrames);
+        for(std::vector<cv::Rect> &detections : frames)
+        {
+            for(SyntheticObject &object : objects)
+            {
+                object.X += object.VelocityX;
+                object.Y += object.VelocityY;
+                if(object.X < 100 || object.X > aArea.width - 100)
+                    object.VelocityX = -object.VelocityX;
+                if(object.Y < 100 || object.Y > aArea.height - 100)
+                    object.VelocityY = -object.VelocityY;
+                //Some detections are missed
+                if(uniform(generator) < 0.1)
+                    continue;
+
+                const int width = 30 + int(uniform(generator)*30), height = 30 + int(uniform(generator)*30);
+                cv::Rect detection(int(object.X) - width/2, int(object.Y) - height/2, width, height);
+                bool merged = false;
+                for(cv::Rect &other : detections)
+                {
+                    if((other & detection).area() > 0)
+                    {
+                        other = other | detection;
+                        merged = true;
+                        break;
+                    }
+                }
+                if(!merged)
+                    detections.push_back(detection);
+            }
+        }
+        return frames;
+    }
+
+    void BenchmarkPairing(const BenchmarkOptions &aOptions, std::vector<BenchmarkResult> &aResults)
+    {
+        const int object_counts[5] = {10, 30, 100, 300, 1000};
+        const AssociationMode modes[2] = {E_greedy_association, E_global_association};
+        const char *mode_names[2] = {"greedy", "global"};
+        const int frames = 100;
+
+        for(int object_count : object_counts)
+        {
+            //Density of objects is the same for all counts
+            const int side = std::max(600, int(60*std::sqrt(double(object_count))*2));
+            const cv::Size area(side, side);
+            const std::vector<std::vector<cv::Rect>> detections = SyntheticDetections(object_count, frames, area);
+            std::shared_ptr<Map> map = std::make_shared<Map>(side, side, 10);
+            //Objects lost in the left half are kept as hidden, objects lost in the right half are deleted
+            cv::Mat hidden_mask(area, CV_8U, cv::Scalar(0));
+            hidden_mask.colRange(0, side/2).setTo(cv::Scalar(255));
+
+            for(int mode = 0; mode < 2; ++mode)
+            {
+                //Whole frame is measured: prediction, objects from the pool, pairing and lost objects
+                //Tracker is reused, so only steady-state frames with warm pools of objects are measured
+                TrackerCore tracker;
+                tracker.SetMap(map);
+                tracker.SetHiddenMask(hidden_mask);
+                tracker.SetAssociationMode(modes[mode]);
+                for(size_t frame = 0; frame < detections.size(); ++frame)
+                    tracker.TrackDetections(detections[frame], frame);
+
+                //Frames are played forward and backward, so objects never jump at the end of the sequence
+                unsigned long frame_index = detections.size();
+                std::ostringstream parameters;
+                parameters << object_count << " objects " << mode_names[mode];
+                Measure(aOptions, aResults, "TrackerCore::TrackDetections", parameters.str(), 1,
+                        [&detections, &tracker, &frame_index, frames]
+                {
+                    const unsigned long phase = frame_index % (2*frames - 2);
+                    const unsigned long frame = phase < (unsigned long)frames ? phase : 2*frames - 2 - phase;
+                    tracker.TrackDetections(detections[frame], frame_index);
+                    ++frame_index;
+                });
+            }
+        }
+    }
+
+    bool WriteJson(const std::string &aFileName, const std::vector<BenchmarkResult> &aResults, double aMinTime)
+    {
+        std::ofstream file(aFileName);
+        if(!file.is_open())
+            return(false);
+
+        file << "{\n  \"context\": {\"compiler\": \"" << __VERSION__ << "\", \"min_time\": " << aMinTime
+#ifdef OT_ENABLE_PROFILING
+             << ", \"profiling\": true},\n";
+#else
+             << ", \"profiling\": false},\n";
+#endif
+        file << "  \"benchmarks\": [\n" << std::setprecision(3) << std::fixed;
+        for(size_t i = 0; i < aResults.size(); ++i)
+        {
+            const BenchmarkResult &result = aResults[i];
+            file << "    {\"name\": \"" << result.Name << "\", \"parameters\": \"" << result.Parameters
+                 << "\", \"operations\": " << result.Operations << ", \"ns_per_op\": "
+                 << result.NanosecondsPerOperation << "}" << (i + 1 < aResults.size() ? "," : "") << "\n";
+        }
+        file << "  ]\n}\n";
+        return(file.good());
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::string json_file = "benchmarks.json";
+    BenchmarkOptions options{"", 0.3};
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if(argument == "--json" && i + 1 < argc)
+            json_file = argv[++i];
+        else if(argument == "--filter" && i + 1 < argc)
+            options.Filter = argv[++i];
+        else if(argument == "--min-time" && i + 1 < argc)
+            options.MinTime = atof(argv[++i]);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--json FILE] [--filter TEXT] [--min-time SECONDS]" << std::endl;
+            return(1);
+        }
+    }
+
+    std::vector<BenchmarkResult> results;
+    std::cout << std::left << std::setw(34) << "benchmark" << std::setw(36) << "parameters" << std::right
+              << std::setw(17) << "time/op" << std::setw(12) << "operations" << std::endl;
+
+    BenchmarkMap(options, results);
+    BenchmarkKalmanFilter<E_constant_velocity>(options, results, "constant velocity");
+    BenchmarkKalmanFilter<E_constant_acceleration>(options, results, "constant acceleration");
+    BenchmarkMultipleTracker(options, results);
+    BenchmarkPairing(options, results);
+
+    if(!WriteJson(json_file, results, options.MinTime))
+    {
+        std::cerr << "Cannot write results to " << json_file << "!" << std::endl;
+        return(1);
+    }
+    std::cout << "Results written to " << json_file << std::endl;
+    return(0);
+}
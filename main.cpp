@@ -8,11 +8,49 @@
  * pointers. Program can be started with argument defining name of a video file or
  * without any argument. In second case user will be asked to enter a file name.
  *
+ * Option --headless turns off all HighGUI windows and keyboard pacing, so the video
+ * is processed as fast as possible. Summary with number of frames and fps is printed
+ * at the end of processing.
+ *
+ * Option --pipeline runs processing of frames in several threads using class FramePipeline.
+ *
+ * Option --compact-map stores new velocity map in 16-bit fixed point cells (see MapCellEncoding).
+ *
+ * Option --sparse-map creates new velocity map from tiles which are allocated only where some
+ * movement is observed.
+ *
+ * Option --checkpoint saves the velocity map in a background thread every minute or after 10000
+ * positions of the map were changed, so learning is not lost if the program is killed.
+ *
+ * Option --global-assignment pairs tracked objects with blobs by a global assignment instead of
+ * the greedy pairing (see AssociationMode).
+ *
+ * Option --track-length N sets number of last positions of every object which are kept and drawn (64 by default,
+ * at most 65536).
+ *
+ * Option --record-tracks FILE writes position of every tracked object in every frame to the file.
+ *
+ * If image video_file.roi.jpg exists, only its nonzero region is processed (see VideoProcessor#OpenRoiMask).
+ *
+ * Option --live plays the video in real time as a camera feed. Frames which would exceed the latency budget
+ * (--latency-budget MS, 200 ms by default) are only decoded and objects are moved by prediction, at most
+ * --max-skip N frames in a row (5 by default). Number of skipped frames and latency are printed at the end.
+ *
+ * Option --profile FILE writes trace of processing stages in Chrome trace format, table of stages and counters
+ * is printed at the end. It needs build with CMake option ENABLE_PROFILING (see Profiler).
+ *
+ * Option --analysis-scale S runs vision stages on frames downscaled by factor S (see VideoProcessor#SetAnalysisScale).
+ *
+ * If more video files are given, all of them are tracked in one process by MultiStreamTracker without any
+ * window, output videos are written unless --headless is given. Option --threads N sets number of its worker
+ * threads (number of cores by default).
+ *
  */
 
 #define __MIN_COMPILER_11 (__cplusplus >= 201103L) ///< C++11 or higher is needed for regular expressions
 
 #include <iostream>
+#include <fstream>
 #include <memory>
 #include <ctime>
 #if __MIN_COMPILER_11
@@ -24,10 +62,26 @@
 #include "modules/VideoProcessor.hpp"
 #include "modules/TrackerCore.hpp"
 #include "modules/TrackerFiles.hpp"
+#include "modules/FramePipeline.hpp"
+#include "modules/MultiStreamTracker.hpp"
+#include "modules/LiveScheduler.hpp"
+#include "modules/Profiler.hpp"
 
 using namespace std;
 using namespace cv;
 
+/// Print table of processing stages and write trace file if it is given, nothing is recorded without profiling
+static void FinishProfiling(const string &aTraceFile)
+{
+#ifdef OT_ENABLE_PROFILING
+    Profiler::Instance().PrintReport(cout);
+    if(!aTraceFile.empty() && !Profiler::Instance().WriteTrace(aTraceFile))
+        cerr << "Cannot write trace file " << aTraceFile << "!" << endl;
+#else
+    (void)aTraceFile;
+#endif
+}
+
 /// Main function
 int main(int argc, char **argv) {
 
@@ -36,13 +90,104 @@ int main(int argc, char **argv) {
     cout << "Object tracker - bachelor project" << endl;
     cout << "Author: Martin Sehnoutka" << endl;
 
-    //Get file name from user
+    //Get options and file name from user
     string file_str;
+    bool headless = false;
+    bool pipeline = false;
+    bool compact_map = false;
+    bool sparse_map = false;
+    bool checkpoint = false;
+    bool global_assignment = false;
+    size_t track_length = TrackHistory::iDefaultCapacity;
+    string track_file;
+    unsigned int thread_count = 0;
+    double analysis_scale = 1.0;
+    bool live = false;
+    double latency_budget = 200;
+    unsigned int max_skip = 5;
+    string trace_file;
+    vector<string> stream_files;
 
-    if(argc > 1)
+    for(int i = 1; i < argc; ++i)
+    {
+        string argument = argv[i];
+        if(argument == "--headless")
+            headless = true;
+        else if(argument == "--pipeline")
+            pipeline = true;
+        else if(argument == "--compact-map")
+            compact_map = true;
+        else if(argument == "--sparse-map")
+            sparse_map = true;
+        else if(argument == "--checkpoint")
+            checkpoint = true;
+        else if(argument == "--global-assignment")
+            global_assignment = true;
+        else if(argument == "--track-length" && i + 1 < argc)
+        {
+            const long length = atol(argv[++i]);
+            if(length > 0)
+                track_length = size_t(length);
+            else
+                cerr << "Track length must be positive, " << track_length << " positions are kept!" << endl;
+        }
+        else if(argument == "--record-tracks" && i + 1 < argc)
+            track_file = argv[++i];
+        else if(argument == "--threads" && i + 1 < argc)
+            thread_count = (unsigned int)atoi(argv[++i]);
+        else if(argument == "--live")
+            live = true;
+        else if(argument == "--latency-budget" && i + 1 < argc)
+            latency_budget = atof(argv[++i]);
+        else if(argument == "--max-skip" && i + 1 < argc)
+            max_skip = (unsigned int)atoi(argv[++i]);
+        else if(argument == "--profile" && i + 1 < argc)
+            trace_file = argv[++i];
+        else if(argument == "--analysis-scale" && i + 1 < argc)
+            analysis_scale = atof(argv[++i]);
+        else
+            stream_files.push_back(argument);
+    }
+
+#ifdef OT_ENABLE_PROFILING
+    Profiler::Instance().SetTraceEnabled(!trace_file.empty());
+#else
+    if(!trace_file.empty())
+        cerr << "Option --profile needs build with ENABLE_PROFILING, no trace is written!" << endl;
+#endif
+
+    if(stream_files.size() > 1)
+    {
+        MultiStreamTracker multi_stream_tracker(thread_count);
+        multi_stream_tracker.SetOutputEnabled(!headless);
+        multi_stream_tracker.SetMapStorage(compact_map ? E_fixed16_cell : E_double_cell, sparse_map ? 16 : 0);
+        multi_stream_tracker.SetAnalysisScale(analysis_scale);
+        if(global_assignment)
+            multi_stream_tracker.SetAssociationMode(E_global_association);
+        for(const string &stream_file : stream_files)
+        {
+            if(!multi_stream_tracker.AddStream(stream_file))
+                cerr << "Stream " << stream_file << " is skipped!" << endl;
+        }
+
+        int64 multi_stream_start = cv::getTickCount();
+        unsigned long all_frames = multi_stream_tracker.Run();
+        double multi_stream_time = double(cv::getTickCount() - multi_stream_start)/cv::getTickFrequency();
+        for(size_t i = 0; i < multi_stream_tracker.GetStreamCount(); ++i)
+            cout << multi_stream_tracker.GetStreamName(i) << ": " << multi_stream_tracker.GetProcessedFrames(i) << " frames" << endl;
+        cout << "Processed frames: " << all_frames << endl;
+        cout << "Elapsed time: " << multi_stream_time << " s" << endl;
+        if(multi_stream_time > 0)
+            cout << "Average speed: " << all_frames/multi_stream_time << " fps" << endl;
+        FinishProfiling(trace_file);
+        return 0;
+    }
+
+    if(!stream_files.empty())
+        file_str = stream_files[0];
+
+    if(file_str.empty())
     {
-        file_str = argv[1];
-    }else{
         cout << "Enter file name: ";
         cin >> file_str;
     }
@@ -92,10 +237,16 @@ int main(int argc, char **argv) {
     video.setVideoSuffix("."+file_array[1]);
     video.setOutputVideoSuffix("_output.avi");
     video.setImageSuffix(".jpg");
-    video.setMapSuffix(".txt");
+    video.setMapSuffix(".map");
     video.setHiddenMaskSuffix(".mask.jpg");
+    video.setRoiMaskSuffix(".roi.jpg");
 
-    shared_ptr<VideoProcessor> video_processor = make_shared<VideoProcessor>();
+    shared_ptr<VideoProcessor> video_processor = make_shared<VideoProcessor>(!headless);
+    if(compact_map)
+        video_processor->SetMapEncoding(E_fixed16_cell);
+    if(sparse_map)
+        video_processor->SetMapTileSize(16);
+    video_processor->SetAnalysisScale(analysis_scale);
     if(!video_processor->OpenFile(video.getVideoName()))
     {
         cerr << "Cannot open video file " << video.getVideoName() << "! Exiting..." << endl;
@@ -114,6 +265,13 @@ int main(int argc, char **argv) {
         return(1);
     }
 
+    //Mask of region of interest is optional
+    if(video_processor->OpenRoiMask(video.getRoiMaskName()))
+    {
+        Rect roi = video_processor->GetRoi();
+        cout << "Region of interest: " << roi.width << "x" << roi.height << " at " << roi.x << ", " << roi.y << endl;
+    }
+
     //video_processor->DisplayFgMask();
     //video_processor->DisplayPreProcess();
     if(!video_processor->SetOutputFile(video.getOutputVideoName()))
@@ -123,21 +281,92 @@ int main(int argc, char **argv) {
 
     shared_ptr<Map> velocity_map = video_processor->GetMap();
     velocity_map->SetFileName(video.getMapName());
-    velocity_map->LoadMap();
-    TrackerBase::SetMapPointer(velocity_map);
+    velocity_map->LoadMap(video.getTextMapName());
+
+    shared_ptr<MapCheckpointer> map_checkpointer;
+    if(checkpoint)
+    {
+        map_checkpointer = make_shared<MapCheckpointer>(velocity_map, 60.0, 10000);
+        video_processor->SetMapCheckpointer(map_checkpointer);
+    }
 
     TrackerCore object_tracker;
     object_tracker.SetVideoProcessor(video_processor);
     object_tracker.SetHiddenMask(video_processor->GetHiddenMask());
+    object_tracker.SetMap(velocity_map);
+    if(global_assignment)
+        object_tracker.SetAssociationMode(E_global_association);
+    object_tracker.SetTrackLength(track_length);
+
+    ofstream track_recorder;
+    if(!track_file.empty())
+    {
+        track_recorder.open(track_file);
+        if(track_recorder.is_open())
+            object_tracker.SetTrackRecorder(&track_recorder);
+        else
+            cerr << "Cannot open file for tracks " << track_file << "!" << endl;
+    }
+
+    //Frames are skipped only in the sequential loop
+    unique_ptr<LiveScheduler> live_scheduler;
+    if(live && pipeline)
+        cerr << "Option --live is ignored with --pipeline!" << endl;
+    else if(live)
+        live_scheduler.reset(new LiveScheduler(video_processor->GetFrameRate(), latency_budget/1000.0, max_skip));
+
+    unsigned long processed_frames = 0;
+    int64 start_ticks = cv::getTickCount();
+    if(live_scheduler != nullptr)
+        live_scheduler->Start();
 
     int keyboard = 0;
-    while(video_processor->ReadNextFrame() && (char)keyboard != 'q' && (char)keyboard != 27)
+    if(pipeline)
     {
-        object_tracker.TrackObjects();
-        object_tracker.DrawObjects();
-        video_processor->DisplayOutput();
+        FramePipeline frame_pipeline(video_processor, &object_tracker);
+        frame_pipeline.SetDrawingEnabled(!headless || video_processor->IsOutputEnabled());
+        processed_frames = frame_pipeline.Run([headless, &keyboard](const VideoFrame &)->bool
+        {
+            if(headless)
+                return true;
+            keyboard = cv::waitKey(30);
+            if((char)keyboard == 'p')
+            {
+                while((char)keyboard != 'c')
+                    keyboard = cv::waitKey( 30 );
+            }
+            return (char)keyboard != 'q' && (char)keyboard != 27;
+        });
+    }
+
+    while(!pipeline && (char)keyboard != 'q' && (char)keyboard != 27)
+    {
+        if(live_scheduler == nullptr || live_scheduler->AnalyseNextFrame())
+        {
+            if(!video_processor->ReadNextFrame())
+                break;
+            object_tracker.TrackObjects();
+        }else{
+            if(!video_processor->SkipFrame())
+                break;
+            object_tracker.PredictObjects();
+        }
+        ++processed_frames;
+
+        //Nothing is displayed in headless mode, draw objects only if output video is written
+        if(!headless || video_processor->IsOutputEnabled())
+        {
+            OT_PROFILE_SCOPE("output");
+            object_tracker.DrawObjects();
+            video_processor->DisplayOutput();
+        }
+        if(live_scheduler != nullptr)
+            live_scheduler->FrameDone();
+        if(headless)
+            continue;
+
         //velocity_map->PlotMap();
-        keyboard = cv::waitKey(30);
+        keyboard = cv::waitKey(live_scheduler != nullptr ? 1 : 30);
         if((char)keyboard == 'p')
         {
             while((char)keyboard != 'c')
@@ -145,7 +374,27 @@ int main(int argc, char **argv) {
         }
     }
 
+    double elapsed_time = double(cv::getTickCount() - start_ticks)/cv::getTickFrequency();
+    cout << "Processed frames: " << processed_frames << endl;
+    cout << "Elapsed time: " << elapsed_time << " s" << endl;
+    if(elapsed_time > 0)
+        cout << "Average speed: " << processed_frames/elapsed_time << " fps" << endl;
+    if(live_scheduler != nullptr)
+    {
+        cout << "Skipped frames: " << live_scheduler->GetSkippedFrames() << endl;
+        cout << "Latency: average " << live_scheduler->GetAverageLatency()*1000 << " ms, maximum "
+             << live_scheduler->GetMaxLatency()*1000 << " ms" << endl;
+    }
+
+    //Wait for the last checkpoint, it writes the same file
+    if(map_checkpointer != nullptr)
+    {
+        video_processor->SetMapCheckpointer(nullptr);
+        cout << "Checkpoints: " << map_checkpointer->GetCheckpointCount() << endl;
+        map_checkpointer = nullptr;
+    }
     velocity_map->SaveMap();
+    FinishProfiling(trace_file);
 
     return 0;
 }
@@ -0,0 +1,154 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "AssignmentSolver.hpp"
+
+AssignmentSolver::AssignmentSolver() :
+        iTrackCount(0),
+        iDetectionCount(0)
+{
+
+}
+
+void AssignmentSolver::Reset(size_t aTrackCount, size_t aDetectionCount)
+{
+    iTrackCount = aTrackCount;
+    iDetectionCount = aDetectionCount;
+    iEdges.clear();
+}
+
+void AssignmentSolver::AddEdge(size_t aTrack, size_t aDetection, double aCost)
+{
+    iEdges.push_back(Edge{int(aTrack), int(aDetection), aCost});
+}
+
+void AssignmentSolver::BuildAdjacency(double aUnassignedCost)
+{
+    //Counting sort of edges by track, the edge to the own column for staying unassigned goes first
+    iAdjacencyStart.assign(iTrackCount + 1, 0);
+    for(const Edge &edge : iEdges)
+        ++iAdjacencyStart[edge.Track + 1];
+    for(size_t i = 0; i < iTrackCount; ++i)
+        iAdjacencyStart[i + 1] += iAdjacencyStart[i] + 1;
+
+    iAdjacencyColumn.resize(iEdges.size() + iTrackCount);
+    iAdjacencyCost.resize(iEdges.size() + iTrackCount);
+    iPredecessor.assign(iAdjacencyStart.begin(), iAdjacencyStart.end() - 1);
+    for(size_t i = 0; i < iTrackCount; ++i)
+    {
+        iAdjacencyColumn[iPredecessor[i]] = int(iDetectionCount + i);
+        iAdjacencyCost[iPredecessor[i]++] = aUnassignedCost;
+    }
+    for(const Edge &edge : iEdges)
+    {
+        iAdjacencyColumn[iPredecessor[edge.Track]] = edge.Detection;
+        iAdjacencyCost[iPredecessor[edge.Track]++] = edge.Cost;
+    }
+}
+
+void AssignmentSolver::Solve(double aUnassignedCost, std::vector<int> &aAssignment)
+{
+    BuildAdjacency(aUnassignedCost);
+
+    const size_t column_count = iDetectionCount + iTrackCount;
+    iRowPotential.assign(iTrackCount, 0.0);
+    iColumnPotential.assign(column_count, 0.0);
+    iDistance.assign(column_count, std::numeric_limits<double>::infinity());
+    iRowMatch.assign(iTrackCount, -1);
+    iColumnMatch.assign(column_count, -1);
+    iPredecessor.assign(column_count, -1);
+    iVisited.assign(column_count, 0);
+
+    for(size_t row = 0; row < iTrackCount; ++row)
+        AugmentRow(int(row));
+
+    aAssignment.resize(iTrackCount);
+    for(size_t row = 0; row < iTrackCount; ++row)
+        aAssignment[row] = size_t(iRowMatch[row]) < iDetectionCount ? iRowMatch[row] : -1;
+}
+
+void AssignmentSolver::AugmentRow(int aRow)
+{
+    //Potentials keep reduced costs c(i,j) - u(i) - v(j) non-negative and zero on matched pairs
+    double &row_potential = iRowPotential[aRow];
+    row_potential = std::numeric_limits<double>::infinity();
+    for(int i = iAdjacencyStart[aRow]; i < iAdjacencyStart[aRow + 1]; ++i)
+        row_potential = std::min(row_potential, iAdjacencyCost[i] - iColumnPotential[iAdjacencyColumn[i]]);
+
+    //Dijkstra over columns, a matched column continues by the row which holds it
+    const std::greater<std::pair<double, int>> later;
+    iQueue.clear();
+    iScanned.clear();
+    int row = aRow;
+    double row_distance = 0.0;
+    int free_column = -1;
+    while(true)
+    {
+        for(int i = iAdjacencyStart[row]; i < iAdjacencyStart[row + 1]; ++i)
+        {
+            const int column = iAdjacencyColumn[i];
+            if(iVisited[column] == 2)
+                continue;
+            const double distance = row_distance + iAdjacencyCost[i] - iRowPotential[row] - iColumnPotential[column];
+            if(iVisited[column] == 0 || distance < iDistance[column])
+            {
+                if(iVisited[column] == 0)
+                    iScanned.push_back(column);
+                iVisited[column] = 1;
+                iDistance[column] = distance;
+                iPredecessor[column] = row;
+                iQueue.push_back(std::make_pair(distance, column));
+                std::push_heap(iQueue.begin(), iQueue.end(), later);
+            }
+        }
+
+        //Column for staying unassigned is free until it is reached, so the queue cannot run empty
+        int column;
+        do
+        {
+            std::pop_heap(iQueue.begin(), iQueue.end(), later);
+            column = iQueue.back().second;
+            row_distance = iQueue.back().first;
+            iQueue.pop_back();
+        }while(iVisited[column] == 2 || row_distance > iDistance[column]);
+        iVisited[column] = 2;
+
+        if(iColumnMatch[column] < 0)
+        {
+            free_column = column;
+            break;
+        }
+        row = iColumnMatch[column];
+    }
+
+    //Update potentials of the finished part of the tree, reduced costs stay non-negative
+    const double path_distance = iDistance[free_column];
+    row_potential += path_distance;
+    for(int column : iScanned)
+    {
+        if(iVisited[column] == 2 && column != free_column)
+        {
+            const double shift = path_distance - iDistance[column];
+            iColumnPotential[column] -= shift;
+            iRowPotential[iColumnMatch[column]] += shift;
+        }
+        iVisited[column] = 0;
+    }
+
+    //Augment along the alternating path
+    int column = free_column;
+    while(column >= 0)
+    {
+        const int previous_row = iPredecessor[column];
+        const int previous_column = iRowMatch[previous_row];
+        iRowMatch[previous_row] = column;
+        iColumnMatch[column] = previous_row;
+        column = previous_column;
+    }
+}
@@ -0,0 +1,72 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class AssignmentSolver
+ *
+ */
+
+#ifndef __ASSIGNMENTSOLVER_HPP__
+#define __ASSIGNMENTSOLVER_HPP__
+
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+/*!
+ * \class AssignmentSolver
+ * \brief Solves sparse assignment of tracks to detections with minimal cost
+ *
+ * Only gated pairs of track and detection are added as edges of a bipartite graph. The assignment is found
+ * by the Hungarian method with shortest augmenting paths (Dijkstra with dual potentials) which visits only
+ * the edges reachable from the inserted track, so the cost depends on the size of clusters of objects close
+ * to each other, not on the number of all objects in the frame.
+ *
+ * Every track can stay unassigned for a fixed cost, therefore a track is assigned only if its pair costs
+ * less than leaving it unassigned and the assignment always exists.
+ */
+class AssignmentSolver
+{
+private:
+    struct Edge
+    {
+        int Track, Detection;
+        double Cost;
+    };
+
+    size_t iTrackCount, iDetectionCount;
+    std::vector<Edge> iEdges;
+
+    //Edges of track i are iAdjacency*[iAdjacencyStart[i]..iAdjacencyStart[i+1]), columns of detections are
+    //followed by one column per track for staying unassigned
+    std::vector<int> iAdjacencyStart, iAdjacencyColumn;
+    std::vector<double> iAdjacencyCost;
+
+    std::vector<double> iRowPotential, iColumnPotential, iDistance;
+    std::vector<int> iRowMatch, iColumnMatch, iPredecessor, iScanned;
+    std::vector<char> iVisited;             ///< 0 not reached, 1 in queue, 2 shortest distance known
+    std::vector<std::pair<double, int>> iQueue;
+
+    void BuildAdjacency(double aUnassignedCost);
+    void AugmentRow(int aRow);
+
+public:
+    /// Constructor
+    AssignmentSolver();
+
+    /// Remove all edges and set number of tracks and detections
+    void Reset(size_t aTrackCount, size_t aDetectionCount);
+
+    /// Add possible pair of track and detection
+    void AddEdge(size_t aTrack, size_t aDetection, double aCost);
+
+    /*!
+     * \brief Find assignment with minimal sum of costs
+     *
+     * aAssignment contains index of detection for every track or -1 for unassigned track. Every detection is
+     * assigned to one track at most.
+     */
+    void Solve(double aUnassignedCost, std::vector<int> &aAssignment);
+};
+
+#endif //__ASSIGNMENTSOLVER_HPP__
@@ -0,0 +1,59 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include "BatchedKalmanFilter.hpp"
+
+template<enum KalmanFilterType ModelType>
+BatchedKalmanFilter<ModelType>::BatchedKalmanFilter(KalmanEngine<KalmanModel<ModelType>::StateSize> &aEngine) :
+    iEngine(aEngine),
+    iSlot(aEngine.AddTrack())
+{
+
+}
+
+template<enum KalmanFilterType ModelType>
+BatchedKalmanFilter<ModelType>::~BatchedKalmanFilter()
+{
+    iEngine.RemoveTrack(iSlot);
+}
+
+template<enum KalmanFilterType ModelType>
+void BatchedKalmanFilter<ModelType>::SetInitialPosition(cv::Point aCenter)
+{
+    iEngine.SetPosition(iSlot, float(aCenter.x), float(aCenter.y));
+}
+
+template<enum KalmanFilterType ModelType>
+void BatchedKalmanFilter<ModelType>::Predict(double aAngle)
+{
+    //Prediction was computed by KalmanEngine::PredictAll
+}
+
+template<enum KalmanFilterType ModelType>
+void BatchedKalmanFilter<ModelType>::Correct(cv::Point aCenter)
+{
+    iEngine.SetMeasurement(iSlot, float(aCenter.x), float(aCenter.y));
+}
+
+template<enum KalmanFilterType ModelType>
+cv::Point BatchedKalmanFilter<ModelType>::GetPredictedCenter() const
+{
+    return cv::Point_<int>(
+            int(iEngine.GetStatePre(iSlot, 0)),
+            int(iEngine.GetStatePre(iSlot, 1))
+    );
+}
+
+template<enum KalmanFilterType ModelType>
+cv::Point BatchedKalmanFilter<ModelType>::GetCorrectedCenter() const
+{
+    return cv::Point_<int>(
+            int(iEngine.GetStatePost(iSlot, 0)),
+            int(iEngine.GetStatePost(iSlot, 1))
+    );
+}
+
+template class BatchedKalmanFilter<E_constant_velocity>;
+template class BatchedKalmanFilter<E_constant_acceleration>;
@@ -0,0 +1,52 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class template BatchedKalmanFilter
+ *
+ */
+
+#ifndef __BATCHEDKALMANFILTER_HPP__
+#define __BATCHEDKALMANFILTER_HPP__
+
+#include <opencv2/core/core.hpp>
+
+#include "TrackerBase.hpp"
+#include "ModifiedKalmanFilter.hpp"
+#include "KalmanEngine.hpp"
+
+/*!
+ * \class BatchedKalmanFilter
+ * \brief Tracker with Kalman filter whose state is stored in KalmanEngine
+ *
+ * Filter is only a slot in the engine. BatchedKalmanFilter#Predict does nothing, the prediction is computed
+ * for all tracks by KalmanEngine#PredictAll before. BatchedKalmanFilter#Correct stores the measurement and
+ * the corrected center is updated by KalmanEngine#CorrectAll.
+ */
+template<enum KalmanFilterType ModelType>
+class BatchedKalmanFilter : public TrackerBase
+{
+private:
+    KalmanEngine<KalmanModel<ModelType>::StateSize> &iEngine;
+    size_t iSlot;
+
+public:
+    /// Constructor allocates a slot in the engine
+    BatchedKalmanFilter(KalmanEngine<KalmanModel<ModelType>::StateSize> &aEngine);
+    /// Destructor frees the slot
+    ~BatchedKalmanFilter();
+
+    BatchedKalmanFilter(const BatchedKalmanFilter &) = delete;
+    BatchedKalmanFilter &operator=(const BatchedKalmanFilter &) = delete;
+
+    void SetInitialPosition(cv::Point aCenter);
+    void Predict(double aAngle);
+    void Correct(cv::Point aCenter);
+    cv::Point GetPredictedCenter() const;
+    cv::Point GetCorrectedCenter() const;
+};
+
+extern template class BatchedKalmanFilter<E_constant_velocity>;
+extern template class BatchedKalmanFilter<E_constant_acceleration>;
+
+#endif //__BATCHEDKALMANFILTER_HPP__
@@ -0,0 +1,175 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+
+#include "BlobExtractor.hpp"
+
+int BlobExtractor::FindRoot(int aRun)
+{
+    //Path halving keeps trees flat without recursion
+    while(iParent[aRun] != aRun)
+    {
+        iParent[aRun] = iParent[iParent[aRun]];
+        aRun = iParent[aRun];
+    }
+    return(aRun);
+}
+
+void BlobExtractor::Join(int aFirst, int aSecond)
+{
+    //Root is the first run of the component in the scan order
+    int first = FindRoot(aFirst), second = FindRoot(aSecond);
+    if(first < second)
+        iParent[second] = first;
+    else if(second < first)
+        iParent[first] = second;
+}
+
+void BlobExtractor::FillOutside(const cv::Rect &aBox, int aRoot)
+{
+    //Box with one pixel of border, pixels of the component are 1, background reachable from the border is 2
+    const int width = aBox.width + 2, height = aBox.height + 2;
+    iOutside.assign(size_t(width)*height, 0);
+    for(size_t i = 0; i < iRuns.size(); ++i)
+    {
+        const Run &run = iRuns[i];
+        if(FindRoot((int)i) != aRoot)
+            continue;
+        uchar *row = iOutside.data() + (run.Row - aBox.y + 1)*width - aBox.x + 1;
+        std::fill(row + run.Start, row + run.End + 1, 1);
+    }
+
+    //Background is 4-connected, components are 8-connected, so diagonal gaps of the component are closed
+    iFillStack.assign(1, 0);
+    iOutside[0] = 2;
+    while(!iFillStack.empty())
+    {
+        const int position = iFillStack.back();
+        iFillStack.pop_back();
+        const int x = position % width, y = position/width;
+        const int neighbours[4] = {x > 0 ? position - 1 : -1, x < width - 1 ? position + 1 : -1,
+                                   y > 0 ? position - width : -1, y < height - 1 ? position + width : -1};
+        for(const int neighbour : neighbours)
+        {
+            if(neighbour >= 0 && iOutside[neighbour] == 0)
+            {
+                iOutside[neighbour] = 2;
+                iFillStack.push_back(neighbour);
+            }
+        }
+    }
+}
+
+const std::vector<Blob> &BlobExtractor::Extract(const cv::Mat &aMask)
+{
+    CV_Assert(aMask.type() == CV_8U);
+
+    iRuns.clear();
+    iParent.clear();
+    iBlobs.clear();
+
+    //Runs of nonzero pixels, each run is joined with 8-connected runs of the previous row
+    size_t previous_start = 0, previous_end = 0;
+    for(int y = 0; y < aMask.rows; ++y)
+    {
+        const uchar *row = aMask.ptr(y);
+        const size_t row_start = iRuns.size();
+        size_t neighbour = previous_start;
+
+        int x = 0;
+        while(x < aMask.cols)
+        {
+            if(!row[x])
+            {
+                ++x;
+                continue;
+            }
+            const int start = x;
+            while(x < aMask.cols && row[x])
+                ++x;
+            const int end = x - 1;
+
+            const int index = (int)iRuns.size();
+            iRuns.push_back(Run{y, start, end});
+            iParent.push_back(index);
+
+            while(neighbour < previous_end && iRuns[neighbour].End < start - 1)
+                ++neighbour;
+            for(size_t i = neighbour; i < previous_end && iRuns[i].Start <= end + 1; ++i)
+                Join((int)i, index);
+        }
+
+        previous_start = row_start;
+        previous_end = iRuns.size();
+    }
+
+    //Statistics are summed in the root run, root precedes all other runs of its component
+    iStatistics.resize(iRuns.size());
+    for(size_t i = 0; i < iRuns.size(); ++i)
+    {
+        const Run &run = iRuns[i];
+        const int length = run.End - run.Start + 1;
+        const int root = FindRoot((int)i);
+        Statistics &statistics = iStatistics[root];
+        if(root == (int)i)
+        {
+            statistics = Statistics{run.Start, run.Row, run.End, run.Row, 0, 0.0, 0.0};
+        }else{
+            statistics.Left = std::min(statistics.Left, run.Start);
+            statistics.Right = std::max(statistics.Right, run.End);
+            statistics.Bottom = run.Row;
+        }
+        statistics.Area += length;
+        statistics.SumX += 0.5*(run.Start + run.End)*length;
+        statistics.SumY += (double)run.Row*length;
+    }
+
+    iBlobRoots.clear();
+    for(size_t i = 0; i < iRuns.size(); ++i)
+    {
+        if(iParent[i] != (int)i)
+            continue;
+        const Statistics &statistics = iStatistics[i];
+        cv::Rect box(statistics.Left, statistics.Top, statistics.Right - statistics.Left + 1,
+                     statistics.Bottom - statistics.Top + 1);
+        if(box.area() <= iMinBoxArea)
+            continue;
+        iBlobs.push_back(Blob{box, statistics.Area, cv::Point2f(float(statistics.SumX/statistics.Area),
+                                                               float(statistics.SumY/statistics.Area))});
+        iBlobRoots.push_back((int)i);
+    }
+
+    //Blobs inside holes of other blobs are dropped, only blobs inside the box of another blob are checked
+    iEnclosed.assign(iBlobs.size(), 0);
+    for(size_t j = 0; j < iBlobs.size(); ++j)
+    {
+        const cv::Rect &outer = iBlobs[j].Box;
+        bool holes_filled = false;
+        for(size_t i = 0; i < iBlobs.size(); ++i)
+        {
+            if(i == j || iEnclosed[i] || (outer & iBlobs[i].Box) != iBlobs[i].Box)
+                continue;
+            if(!holes_filled)
+            {
+                FillOutside(outer, iBlobRoots[j]);
+                holes_filled = true;
+            }
+            //Component is not connected to the outer one, so any of its pixels is either in a hole or outside
+            const Run &run = iRuns[iBlobRoots[i]];
+            if(iOutside[(run.Row - outer.y + 1)*(outer.width + 2) + run.Start - outer.x + 1] == 0)
+                iEnclosed[i] = 1;
+        }
+    }
+    size_t kept = 0;
+    for(size_t i = 0; i < iBlobs.size(); ++i)
+    {
+        if(!iEnclosed[i])
+            iBlobs[kept++] = iBlobs[i];
+    }
+    iBlobs.resize(kept);
+
+    return(iBlobs);
+}
@@ -0,0 +1,83 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class BlobExtractor
+ *
+ */
+
+#ifndef __BLOBEXTRACTOR_HPP__
+#define __BLOBEXTRACTOR_HPP__
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+//! Connected component of foreground mask
+struct Blob
+{
+    cv::Rect Box;           ///< Bounding box
+    int Area;               ///< Number of pixels
+    cv::Point2f Centroid;   ///< Mean position of pixels
+};
+
+/*!
+ * \class BlobExtractor
+ * \brief Finds 8-connected components of a mask with their bounding boxes, areas and centroids in one pass
+ *
+ * Mask is scanned row by row and every horizontal run of nonzero pixels gets a label. Runs touching runs of
+ * the previous row are joined by union-find, statistics of components are then summed over the runs. Only
+ * components with bounding box bigger than BlobExtractor#SetMinBoxArea are returned, buffers of runs and
+ * statistics are kept between calls, so noise with thousands of tiny components needs no allocation.
+ *
+ * Component inside a hole of another returned component is dropped, as it was not found by external contours
+ * used before. Only components inside the bounding box of another one are checked: background of the box which
+ * is not reachable from its border is filled. Components next to a concave part of another one (inside an L
+ * or U shape) are kept.
+ */
+class BlobExtractor
+{
+private:
+    struct Run
+    {
+        int Row, Start, End;    ///< Pixels Start..End (inclusive) of the row
+    };
+
+    struct Statistics
+    {
+        int Left, Top, Right, Bottom;
+        int Area;
+        double SumX, SumY;
+    };
+
+    int iMinBoxArea;
+    std::vector<Run> iRuns;
+    std::vector<int> iParent;
+    std::vector<Statistics> iStatistics;
+    std::vector<Blob> iBlobs;
+    std::vector<int> iBlobRoots;            ///< Root run of every blob
+    std::vector<char> iEnclosed;
+    std::vector<uchar> iOutside;            ///< Box of a blob, background reachable from outside is 2
+    std::vector<int> iFillStack;
+
+    int FindRoot(int aRun);
+    void Join(int aFirst, int aSecond);
+    //! Mark background of box aBox reachable from outside around the component with root run aRoot
+    void FillOutside(const cv::Rect &aBox, int aRoot);
+
+public:
+    //! Constructor, components with bounding box up to aMinBoxArea pixels are ignored
+    explicit BlobExtractor(int aMinBoxArea = 0) : iMinBoxArea(aMinBoxArea) {}
+
+    //! Set minimal area of bounding box (exclusive) of returned components
+    void SetMinBoxArea(int aMinBoxArea) { iMinBoxArea = aMinBoxArea; }
+
+    /*!
+     * \brief Find components of 8-bit mask (nonzero pixels), coordinates are relative to the mask
+     *
+     * Returned vector is valid until the next call.
+     */
+    const std::vector<Blob> &Extract(const cv::Mat &aMask);
+};
+
+#endif //__BLOBEXTRACTOR_HPP__
@@ -0,0 +1,83 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration and implementation of template class BoundedQueue
+ *
+ */
+
+#ifndef __BOUNDEDQUEUE_HPP__
+#define __BOUNDEDQUEUE_HPP__
+
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+
+/*!
+ * \class BoundedQueue
+ * \brief Thread safe FIFO queue with limited capacity
+ *
+ * BoundedQueue#Push blocks while the queue is full (back-pressure) and BoundedQueue#Pop blocks while the queue
+ * is empty. After BoundedQueue#Close is called, no item can be pushed and BoundedQueue#Pop returns remaining
+ * items and then false.
+ */
+template<typename T>
+class BoundedQueue
+{
+private:
+    std::deque<T> iItems;
+    const size_t iCapacity;
+    bool iClosed;
+    std::mutex iMutex;
+    std::condition_variable iNotFull, iNotEmpty;
+
+public:
+    /// Constructor with maximal number of items in queue
+    explicit BoundedQueue(size_t aCapacity) :
+            iCapacity(aCapacity > 0 ? aCapacity : 1),
+            iClosed(false)
+    {}
+
+    BoundedQueue(const BoundedQueue &) = delete;
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    /// Insert item at the end of queue, return false if the queue was closed
+    bool Push(T aItem)
+    {
+        std::unique_lock<std::mutex> lock(iMutex);
+        iNotFull.wait(lock, [this]{ return iClosed || iItems.size() < iCapacity; });
+        if(iClosed)
+            return(false);
+        iItems.push_back(std::move(aItem));
+        lock.unlock();
+        iNotEmpty.notify_one();
+        return(true);
+    }
+
+    /// Remove item from the front of queue, return false if the queue is closed and empty
+    bool Pop(T &aItem)
+    {
+        std::unique_lock<std::mutex> lock(iMutex);
+        iNotEmpty.wait(lock, [this]{ return iClosed || !iItems.empty(); });
+        if(iItems.empty())
+            return(false);
+        aItem = std::move(iItems.front());
+        iItems.pop_front();
+        lock.unlock();
+        iNotFull.notify_one();
+        return(true);
+    }
+
+    /// Close the queue and wake up all waiting threads
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(iMutex);
+            iClosed = true;
+        }
+        iNotFull.notify_all();
+        iNotEmpty.notify_all();
+    }
+};
+
+#endif //__BOUNDEDQUEUE_HPP__
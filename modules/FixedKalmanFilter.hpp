@@ -0,0 +1,125 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration and implementation of class template FixedKalmanFilter
+ *
+ */
+
+#ifndef __FIXEDKALMANFILTER_HPP__
+#define __FIXEDKALMANFILTER_HPP__
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \class FixedKalmanFilter
+ * \brief Kalman filter of fixed size for models of position and its derivatives
+ *
+ * State is (x, y, x', y', x'', y'', ...) and only position (x, y) is measured. Transition matrix is identity
+ * with the time step T above the diagonal shifted by two (every derivative is added to the lower one), process
+ * noise, measurement noise and initial error covariance are scaled identities. For this structure prediction
+ * and correction are written in closed form on fixed size matrices cv::Matx, so the filter does not allocate
+ * any memory and it does not multiply by zeros.
+ *
+ * Semantics is the same as of cv::KalmanFilter: prediction sets both predicted and corrected state, correction
+ * is computed from the predicted state.
+ */
+template<int StateSize>
+class FixedKalmanFilter
+{
+public:
+    typedef cv::Matx<float, StateSize, 1> StateVector;
+    typedef cv::Matx<float, StateSize, StateSize> CovarianceMatrix;
+
+private:
+    static_assert(StateSize >= 4 && StateSize % 2 == 0, "State must contain position and its derivatives");
+
+    float iTimeStep, iProcessNoise, iMeasurementNoise;
+    StateVector iStatePre, iStatePost;
+    CovarianceMatrix iErrorCovPre, iErrorCovPost;
+
+public:
+    //! Constructor sets zero state and the diagonal matrices
+    FixedKalmanFilter(float aTimeStep, float aProcessNoise, float aMeasurementNoise, float aErrorCovariance) :
+            iTimeStep(aTimeStep),
+            iProcessNoise(aProcessNoise),
+            iMeasurementNoise(aMeasurementNoise),
+            iStatePre(StateVector::zeros()),
+            iStatePost(StateVector::zeros()),
+            iErrorCovPre(CovarianceMatrix::eye()*aErrorCovariance),
+            iErrorCovPost(CovarianceMatrix::eye()*aErrorCovariance)
+    {
+
+    }
+
+    //! Set position in predicted and corrected state
+    void SetPosition(float aX, float aY)
+    {
+        iStatePre(0) = iStatePost(0) = aX;
+        iStatePre(1) = iStatePost(1) = aY;
+    }
+
+    //! x = F*x, P = F*P*F' + Q
+    void Predict()
+    {
+        const float T = iTimeStep;
+        for(int i = 0; i < StateSize - 2; ++i)
+            iStatePre(i) = iStatePost(i) + T*iStatePost(i + 2);
+        for(int i = StateSize - 2; i < StateSize; ++i)
+            iStatePre(i) = iStatePost(i);
+
+        //Rows of F*P, then columns of (F*P)*F'
+        CovarianceMatrix product;
+        for(int i = 0; i < StateSize; ++i)
+            for(int j = 0; j < StateSize; ++j)
+                product(i, j) = i < StateSize - 2 ? iErrorCovPost(i, j) + T*iErrorCovPost(i + 2, j) : iErrorCovPost(i, j);
+        for(int i = 0; i < StateSize; ++i)
+        {
+            for(int j = 0; j < StateSize; ++j)
+                iErrorCovPre(i, j) = j < StateSize - 2 ? product(i, j) + T*product(i, j + 2) : product(i, j);
+            iErrorCovPre(i, i) += iProcessNoise;
+        }
+
+        iStatePost = iStatePre;
+        iErrorCovPost = iErrorCovPre;
+    }
+
+    //! K = P*H'*(H*P*H' + R)^-1, x = x + K*(z - H*x), P = P - K*H*P
+    void Correct(float aX, float aY)
+    {
+        //H*P*H' + R is the top left 2x2 block of P with noise on the diagonal
+        const double s00 = double(iErrorCovPre(0, 0)) + iMeasurementNoise;
+        const double s01 = iErrorCovPre(0, 1);
+        const double s10 = iErrorCovPre(1, 0);
+        const double s11 = double(iErrorCovPre(1, 1)) + iMeasurementNoise;
+        const double inverse_determinant = 1.0/(s00*s11 - s01*s10);
+        const double i00 = s11*inverse_determinant, i01 = -s01*inverse_determinant;
+        const double i10 = -s10*inverse_determinant, i11 = s00*inverse_determinant;
+
+        //P*H' are the first two columns of P
+        cv::Matx<float, StateSize, 2> gain;
+        for(int i = 0; i < StateSize; ++i)
+        {
+            gain(i, 0) = float(iErrorCovPre(i, 0)*i00 + iErrorCovPre(i, 1)*i10);
+            gain(i, 1) = float(iErrorCovPre(i, 0)*i01 + iErrorCovPre(i, 1)*i11);
+        }
+
+        const float residual_x = aX - iStatePre(0);
+        const float residual_y = aY - iStatePre(1);
+        for(int i = 0; i < StateSize; ++i)
+        {
+            iStatePost(i) = iStatePre(i) + gain(i, 0)*residual_x + gain(i, 1)*residual_y;
+            //H*P are the first two rows of P
+            for(int j = 0; j < StateSize; ++j)
+                iErrorCovPost(i, j) = iErrorCovPre(i, j) - (gain(i, 0)*iErrorCovPre(0, j) + gain(i, 1)*iErrorCovPre(1, j));
+        }
+    }
+
+    //! Return state after prediction
+    const StateVector &GetStatePre() const { return iStatePre; }
+
+    //! Return state after correction
+    const StateVector &GetStatePost() const { return iStatePost; }
+};
+
+#endif //__FIXEDKALMANFILTER_HPP__
@@ -0,0 +1,88 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include "FrameBufferPool.hpp"
+
+FrameBufferPool::FrameBufferPool() :
+        iClosed(false)
+{
+
+}
+
+void FrameBufferPool::AllocateFrame(VideoFrame &aFrame, cv::Size aSize, cv::Size aAnalysisSize)
+{
+    if(aSize.area() == 0)
+        return;
+    if(aAnalysisSize.area() == 0)
+        aAnalysisSize = aSize;
+
+    aFrame.Frame.create(aSize, CV_8UC3);
+    if(aAnalysisSize != aSize)
+        aFrame.Analysis.create(aAnalysisSize, CV_8UC3);
+    else
+        aFrame.Analysis.release();
+    aFrame.PreProcessed.create(aAnalysisSize, CV_8UC3);
+    aFrame.Gray.create(aAnalysisSize, CV_8U);
+    aFrame.FgMask.create(aAnalysisSize, CV_8U);
+    //Only region of interest is written by background subtraction, the rest of mask is always empty
+    aFrame.FgMask.setTo(cv::Scalar(0));
+}
+
+void FrameBufferPool::SetFrameSize(cv::Size aSize, cv::Size aAnalysisSize)
+{
+    std::lock_guard<std::mutex> lock(iMutex);
+    iFrameSize = aSize;
+    iAnalysisSize = aAnalysisSize;
+    for(auto &frame : iFrames)
+        AllocateFrame(*frame, iFrameSize, iAnalysisSize);
+}
+
+void FrameBufferPool::Reserve(size_t aCount)
+{
+    std::lock_guard<std::mutex> lock(iMutex);
+    while(iFrames.size() < aCount)
+    {
+        iFrames.emplace_back(new VideoFrame);
+        AllocateFrame(*iFrames.back(), iFrameSize, iAnalysisSize);
+        iFreeFrames.push_back(iFrames.back().get());
+    }
+    iFrameReturned.notify_all();
+}
+
+FrameBufferPool::FramePtr FrameBufferPool::Acquire()
+{
+    std::unique_lock<std::mutex> lock(iMutex);
+    iFrameReturned.wait(lock, [this]{ return iClosed || !iFreeFrames.empty(); });
+    if(iClosed)
+        return FramePtr(nullptr, FrameReleaser{this});
+
+    VideoFrame *frame = iFreeFrames.back();
+    iFreeFrames.pop_back();
+    return FramePtr(frame, FrameReleaser{this});
+}
+
+void FrameBufferPool::Release(VideoFrame *aFrame)
+{
+    {
+        std::lock_guard<std::mutex> lock(iMutex);
+        iFreeFrames.push_back(aFrame);
+    }
+    iFrameReturned.notify_one();
+}
+
+void FrameBufferPool::Close()
+{
+    {
+        std::lock_guard<std::mutex> lock(iMutex);
+        iClosed = true;
+    }
+    iFrameReturned.notify_all();
+}
+
+void FrameBufferPool::Open()
+{
+    std::lock_guard<std::mutex> lock(iMutex);
+    iClosed = false;
+}
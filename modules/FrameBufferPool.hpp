@@ -0,0 +1,77 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class FrameBufferPool
+ *
+ */
+
+#ifndef __FRAMEBUFFERPOOL_HPP__
+#define __FRAMEBUFFERPOOL_HPP__
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+
+#include <opencv2/core/core.hpp>
+
+#include "VideoFrame.hpp"
+
+/*!
+ * \class FrameBufferPool
+ * \brief Pool of preallocated video frames which are recycled instead of allocating new images for every frame
+ *
+ * Frames are borrowed by FrameBufferPool#Acquire and returned automatically when the returned pointer is
+ * destroyed. If all frames are borrowed, FrameBufferPool#Acquire waits until some frame is returned.
+ */
+class FrameBufferPool
+{
+private:
+    std::vector<std::unique_ptr<VideoFrame> > iFrames;
+    std::vector<VideoFrame *> iFreeFrames;
+    cv::Size iFrameSize, iAnalysisSize;
+    bool iClosed;
+    std::mutex iMutex;
+    std::condition_variable iFrameReturned;
+
+    void Release(VideoFrame *aFrame);
+
+public:
+    /// Deleter which returns frame back to the pool
+    struct FrameReleaser
+    {
+        FrameBufferPool *Pool;
+        void operator()(VideoFrame *aFrame) const { Pool->Release(aFrame); }
+    };
+
+    /// Pointer to frame borrowed from the pool
+    typedef std::unique_ptr<VideoFrame, FrameReleaser> FramePtr;
+
+    /// Constructor
+    FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool &) = delete;
+    FrameBufferPool &operator=(const FrameBufferPool &) = delete;
+
+    /// Allocate all buffers of the frame for given video size and size of analysis images (video size if empty)
+    static void AllocateFrame(VideoFrame &aFrame, cv::Size aSize, cv::Size aAnalysisSize = cv::Size());
+
+    /// Set video size and size of analysis images (video size if empty), buffers of all frames in pool are
+    /// reallocated. Must not be called while frames are borrowed.
+    void SetFrameSize(cv::Size aSize, cv::Size aAnalysisSize = cv::Size());
+
+    /// Make sure there are at least aCount frames in pool
+    void Reserve(size_t aCount);
+
+    /// Borrow frame, wait if there is no free frame. Return empty pointer if the pool is closed.
+    FramePtr Acquire();
+
+    /// Wake up all threads waiting in FrameBufferPool#Acquire, no frame can be borrowed until FrameBufferPool#Open
+    void Close();
+
+    /// Allow borrowing of frames again
+    void Open();
+};
+
+#endif //__FRAMEBUFFERPOOL_HPP__
@@ -0,0 +1,129 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <thread>
+#include <vector>
+
+#include "FramePipeline.hpp"
+
+FramePipeline::FramePipeline(std::shared_ptr<VideoProcessor> aVideoProcessor, TrackerCore *aTracker, size_t aQueueCapacity) :
+        iVideoProcessor(aVideoProcessor),
+        iTracker(aTracker),
+        iQueueCapacity(aQueueCapacity),
+        iPoolSize(aQueueCapacity + 5), //one frame for each stage and some frames in queues
+        iDrawObjects(true),
+        iStop(false)
+{
+
+}
+
+void FramePipeline::SaveError(std::exception_ptr aError)
+{
+    std::lock_guard<std::mutex> lock(iErrorMutex);
+    if(!iError)
+        iError = aError;
+    iStop = true;
+}
+
+void FramePipeline::RunStage(FrameQueue &aInput, FrameQueue &aOutput, const std::function<void(VideoFrame &)> &aWork)
+{
+    try
+    {
+        FramePtr frame;
+        while(!iStop && aInput.Pop(frame))
+        {
+            aWork(*frame);
+            if(!aOutput.Push(std::move(frame)))
+                break;
+        }
+    }catch(...){
+        SaveError(std::current_exception());
+    }
+    aOutput.Close();
+}
+
+unsigned long FramePipeline::Run(const std::function<bool(const VideoFrame &)> &aOutput)
+{
+    FrameQueue decoded(iQueueCapacity), segmented(iQueueCapacity), featured(iQueueCapacity), tracked(iQueueCapacity);
+    FrameQueue *queues[] = {&decoded, &segmented, &featured, &tracked};
+
+    FrameBufferPool &pool = iVideoProcessor->GetFramePool();
+    pool.Reserve(iPoolSize);
+    pool.Open();
+
+    iStop = false;
+    iError = nullptr;
+
+    auto close_queues = [&queues, &pool]()
+    {
+        pool.Close();
+        for(FrameQueue *queue : queues)
+            queue->Close();
+    };
+
+    std::vector<std::thread> stages;
+
+    stages.emplace_back([this, &decoded, &pool]()
+    {
+        try
+        {
+            while(!iStop)
+            {
+                FramePtr frame = pool.Acquire();
+                if(!frame || !iVideoProcessor->DecodeFrame(*frame))
+                    break;
+                if(!decoded.Push(std::move(frame)))
+                    break;
+            }
+        }catch(...){
+            SaveError(std::current_exception());
+        }
+        decoded.Close();
+    });
+
+    stages.emplace_back(&FramePipeline::RunStage, this, std::ref(decoded), std::ref(segmented),
+            [this](VideoFrame &aFrame){ iVideoProcessor->SubtractBackground(aFrame); });
+
+    stages.emplace_back(&FramePipeline::RunStage, this, std::ref(segmented), std::ref(featured),
+            [this](VideoFrame &aFrame){ iVideoProcessor->FindFeatures(aFrame); });
+
+    stages.emplace_back(&FramePipeline::RunStage, this, std::ref(featured), std::ref(tracked),
+            [this](VideoFrame &aFrame)
+            {
+                iVideoProcessor->UpdateMap(aFrame);
+                iTracker->TrackObjects(aFrame);
+                if(iDrawObjects)
+                    iTracker->DrawObjects(aFrame.Frame);
+            });
+
+    //Output stage
+    unsigned long processed_frames = 0;
+    try
+    {
+        FramePtr frame;
+        while(!iStop && tracked.Pop(frame))
+        {
+            iVideoProcessor->DisplayOutput(*frame);
+            ++processed_frames;
+            if(aOutput && !aOutput(*frame))
+                break;
+            //Return the frame to pool before waiting for the next one
+            frame.reset();
+        }
+    }catch(...){
+        SaveError(std::current_exception());
+    }
+
+    //Wake up all stages which are waiting for a queue and wait for them
+    iStop = true;
+    close_queues();
+    for(std::thread &stage : stages)
+        stage.join();
+
+    if(iError)
+        std::rethrow_exception(iError);
+
+    return processed_frames;
+}
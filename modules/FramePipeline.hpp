@@ -0,0 +1,76 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class FramePipeline
+ *
+ */
+
+#ifndef __FRAMEPIPELINE_HPP__
+#define __FRAMEPIPELINE_HPP__
+
+#include <memory>
+#include <functional>
+#include <atomic>
+#include <mutex>
+#include <exception>
+
+#include "VideoProcessor.hpp"
+#include "TrackerCore.hpp"
+#include "BoundedQueue.hpp"
+
+/*!
+ * \class FramePipeline
+ * \brief Runs processing of video frames in several threads
+ *
+ * Processing of every frame is split into five stages: decoding, background subtraction, optical flow with
+ * good features, tracking (together with map update and drawing of objects) and output. First four stages
+ * run in their own threads, output stage runs in the thread which called FramePipeline#Run, so HighGUI
+ * windows can be used there. Stages are connected by bounded queues, so a slow stage stops the previous ones
+ * and frames are always delivered in order.
+ *
+ * Map is updated in the tracking stage right before the objects are tracked, therefore the tracker sees
+ * exactly the same map as in the sequential processing by VideoProcessor#ReadNextFrame and
+ * TrackerCore#TrackObjects.
+ *
+ * Frames are borrowed from FrameBufferPool of the video processor, so no image is allocated while the video
+ * is processed. Size of the pool is also a limit of frames being processed at the same time.
+ *
+ * Pre-processing in the background subtraction stage still runs in parallel (FramePreProcessor#Process). The
+ * pipeline has only four busy threads, so the remaining cores are used for tiles of one frame.
+ */
+class FramePipeline
+{
+private:
+    typedef FrameBufferPool::FramePtr FramePtr;
+    typedef BoundedQueue<FramePtr> FrameQueue;
+
+    std::shared_ptr<VideoProcessor> iVideoProcessor;
+    TrackerCore *iTracker;
+    size_t iQueueCapacity, iPoolSize;
+    bool iDrawObjects;
+
+    std::atomic<bool> iStop;
+    std::mutex iErrorMutex;
+    std::exception_ptr iError;
+
+    void RunStage(FrameQueue &aInput, FrameQueue &aOutput, const std::function<void(VideoFrame &)> &aWork);
+    void SaveError(std::exception_ptr aError);
+
+public:
+    /// Constructor, aQueueCapacity is maximal number of frames waiting between two stages
+    FramePipeline(std::shared_ptr<VideoProcessor> aVideoProcessor, TrackerCore *aTracker, size_t aQueueCapacity = 4);
+
+    /// Turn on or off drawing of objects to frames (it is not necessary in headless mode without output video)
+    void SetDrawingEnabled(bool aEnabled) { iDrawObjects = aEnabled; }
+
+    /*!
+     * \brief Process whole video and return number of processed frames
+     *
+     * Function aOutput is called for every processed frame in the calling thread after the frame is displayed.
+     * Processing stops when the function returns false.
+     */
+    unsigned long Run(const std::function<bool(const VideoFrame &)> &aOutput);
+};
+
+#endif //__FRAMEPIPELINE_HPP__
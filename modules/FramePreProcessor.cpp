@@ -0,0 +1,187 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "FramePreProcessor.hpp"
+
+namespace
+{
+    const int kKernelSize = 5;
+    const int kKernelRadius = kKernelSize/2;
+    const int kChannels = 3;
+    const int kFilterBits = 16;     ///< Fixed point bits of both passes together (8 bits per pass)
+    const int kGrayBits = 14;       ///< Fixed point bits of conversion to gray, same as cvtColor
+
+    //! Coefficients of pre-processing computed in the same way as by OpenCV functions
+    struct Coefficients
+    {
+        int Kernel[kKernelSize];
+        uchar Gain[256];
+
+        Coefficients()
+        {
+            cv::Mat kernel = cv::getGaussianKernel(kKernelSize, 2, CV_32F);
+            for(int i = 0; i < kKernelSize; ++i)
+                Kernel[i] = cvRound(kernel.at<float>(i)*(1 << (kFilterBits/2)));
+
+            //convertTo computes in float for 8-bit images
+            const float gain = 1.1f;
+            for(int i = 0; i < 256; ++i)
+                Gain[i] = cv::saturate_cast<uchar>(i*gain + 0.0f);
+        }
+    };
+
+    const Coefficients &GetCoefficients()
+    {
+        static const Coefficients coefficients;
+        return coefficients;
+    }
+
+    //! Position inside image of length aLength with border reflected as BORDER_REFLECT_101
+    int Reflect(int aPosition, int aLength)
+    {
+        if(aLength == 1)
+            return(0);
+        while(aPosition < 0 || aPosition >= aLength)
+            aPosition = aPosition < 0 ? -aPosition : 2*aLength - 2 - aPosition;
+        return(aPosition);
+    }
+
+    class PreProcessBody : public cv::ParallelLoopBody
+    {
+    private:
+        const cv::Mat &iFrame;
+        cv::Mat &iPreProcessed;
+        cv::Mat *iGray;
+        cv::Size iWholeSize;
+        cv::Point iOffset;
+        const Coefficients &iCoefficients;
+
+        //! Pointer to row of the frame, rows outside are reflected at borders of the parent image
+        const uchar *SourceRow(int aRow) const
+        {
+            return iFrame.ptr(0) + (ptrdiff_t)(Reflect(iOffset.y + aRow, iWholeSize.height) - iOffset.y)*iFrame.step;
+        }
+
+        //! Filter row of the frame horizontally, aExtended is buffer for the row with borders
+        void HorizontalPass(int aRow, int *aOutput, uchar *aExtended) const
+        {
+            const uchar *source = SourceRow(aRow);
+            const int width = iFrame.cols, length = width*kChannels;
+
+            std::memcpy(aExtended + kKernelRadius*kChannels, source, length);
+            for(int i = 0; i < kKernelRadius; ++i)
+            {
+                int left = Reflect(iOffset.x - kKernelRadius + i, iWholeSize.width) - iOffset.x;
+                int right = Reflect(iOffset.x + width + i, iWholeSize.width) - iOffset.x;
+                std::memcpy(aExtended + i*kChannels, source + (ptrdiff_t)left*kChannels, kChannels);
+                std::memcpy(aExtended + (kKernelRadius + width + i)*kChannels, source + (ptrdiff_t)right*kChannels, kChannels);
+            }
+
+            //Kernel is symmetric, plain loop over interleaved channels is vectorized by the compiler
+            const int *k = iCoefficients.Kernel;
+            const uchar *e = aExtended;
+            for(int i = 0; i < length; ++i)
+            {
+                aOutput[i] = k[0]*(e[i] + e[i + 4*kChannels]) + k[1]*(e[i + kChannels] + e[i + 3*kChannels]) +
+                             k[2]*e[i + 2*kChannels];
+            }
+        }
+
+        //! Filter five horizontally filtered rows vertically and apply the gain
+        void VerticalPass(const int *const aRows[kKernelSize], uchar *aOutput, int aLength) const
+        {
+            const int *k = iCoefficients.Kernel;
+            const uchar *gain = iCoefficients.Gain;
+            const int *r0 = aRows[0], *r1 = aRows[1], *r2 = aRows[2], *r3 = aRows[3], *r4 = aRows[4];
+            for(int i = 0; i < aLength; ++i)
+            {
+                int value = (k[0]*(r0[i] + r4[i]) + k[1]*(r1[i] + r3[i]) + k[2]*r2[i] + (1 << (kFilterBits - 1))) >> kFilterBits;
+                aOutput[i] = gain[std::min(value, 255)];
+            }
+        }
+
+        //! Same coefficients and rounding as cvtColor with COLOR_RGB2GRAY
+        static void GrayRow(const uchar *aSource, uchar *aOutput, int aWidth)
+        {
+            for(int x = 0; x < aWidth; ++x)
+            {
+                const uchar *pixel = aSource + x*kChannels;
+                aOutput[x] = (uchar)((pixel[0]*4899 + pixel[1]*9617 + pixel[2]*1868 + (1 << (kGrayBits - 1))) >> kGrayBits);
+            }
+        }
+
+    public:
+        PreProcessBody(const cv::Mat &aFrame, cv::Mat &aPreProcessed, cv::Mat *aGray) :
+                iFrame(aFrame),
+                iPreProcessed(aPreProcessed),
+                iGray(aGray),
+                iCoefficients(GetCoefficients())
+        {
+            iFrame.locateROI(iWholeSize, iOffset);
+        }
+
+        void operator()(const cv::Range &aTiles) const
+        {
+            const int width = iFrame.cols, length = width*kChannels;
+            std::vector<uchar> extended((width + 2*kKernelRadius)*kChannels);
+            std::vector<int> ring(kKernelSize*length);
+            auto ring_row = [&ring, length](int aRow) { return ring.data() + ((aRow%kKernelSize + kKernelSize)%kKernelSize)*length; };
+
+            for(int tile = aTiles.start; tile < aTiles.end; ++tile)
+            {
+                const int first = tile*FramePreProcessor::iTileRows;
+                const int last = std::min(first + FramePreProcessor::iTileRows, iFrame.rows);
+
+                for(int y = first - kKernelRadius; y < first + kKernelRadius; ++y)
+                    HorizontalPass(y, ring_row(y), extended.data());
+
+                for(int y = first; y < last; ++y)
+                {
+                    HorizontalPass(y + kKernelRadius, ring_row(y + kKernelRadius), extended.data());
+                    const int *rows[kKernelSize];
+                    for(int i = 0; i < kKernelSize; ++i)
+                        rows[i] = ring_row(y - kKernelRadius + i);
+                    VerticalPass(rows, iPreProcessed.ptr(y), length);
+
+                    if(iGray)
+                        GrayRow(iFrame.ptr(y), iGray->ptr(y), width);
+                }
+            }
+        }
+    };
+}
+
+void FramePreProcessor::Process(const cv::Mat &aFrame, cv::Mat &aPreProcessed, cv::Mat *aGray, bool aParallel)
+{
+    if(aFrame.type() != CV_8UC3 || aFrame.empty())
+    {
+        ProcessReference(aFrame, aPreProcessed, aGray);
+        return;
+    }
+
+    aPreProcessed.create(aFrame.size(), CV_8UC3);
+    if(aGray)
+        aGray->create(aFrame.size(), CV_8U);
+
+    const int tiles = (aFrame.rows + iTileRows - 1)/iTileRows;
+    if(aParallel)
+        cv::parallel_for_(cv::Range(0, tiles), PreProcessBody(aFrame, aPreProcessed, aGray));
+    else
+        PreProcessBody(aFrame, aPreProcessed, aGray)(cv::Range(0, tiles));
+}
+
+void FramePreProcessor::ProcessReference(const cv::Mat &aFrame, cv::Mat &aPreProcessed, cv::Mat *aGray)
+{
+    cv::GaussianBlur(aFrame, aPreProcessed, cv::Size(5,5), 2);
+    aPreProcessed.convertTo(aPreProcessed, -1, 1.1, 0);
+    if(aGray)
+        cv::cvtColor(aFrame, *aGray, cv::COLOR_RGB2GRAY, CV_8U);
+}
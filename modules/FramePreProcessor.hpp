@@ -0,0 +1,48 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class FramePreProcessor
+ *
+ */
+
+#ifndef __FRAMEPREPROCESSOR_HPP__
+#define __FRAMEPREPROCESSOR_HPP__
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \class FramePreProcessor
+ * \brief Pre-processing of a video frame (Gaussian blur, gain and conversion to gray) in one pass
+ *
+ * Original pre-processing called GaussianBlur (5x5, sigma 2), convertTo with gain 1.1 and cvtColor, every call
+ * read and wrote the whole frame. FramePreProcessor#Process does all of it in one sweep over tiles of
+ * FramePreProcessor#iTileRows rows which are processed in parallel by cv::parallel_for_. Each tile keeps
+ * horizontally filtered rows in a ring of five rows, so every source row is read from memory once and every
+ * output row is written once.
+ *
+ * Blur uses the same 8-bit fixed point kernel as GaussianBlur of OpenCV 2.4, borders are reflected (including
+ * pixels of parent image if the frame is a view of a region). Gray image is bit-exact. Blurred image is bit-exact
+ * against the scalar path of OpenCV, its SSE2 column filter rounds in float and may differ by one level before
+ * the gain, i.e. at most 2 levels after it (see PreProcessing test).
+ */
+class FramePreProcessor
+{
+public:
+    static const int iTileRows = 32;    ///< Rows processed by one parallel task
+
+    /*!
+     * \brief Blur aFrame and multiply it by the gain into aPreProcessed, convert aFrame to gray into aGray
+     *
+     * aFrame must be 8-bit 3 channel image, other types are processed by FramePreProcessor#ProcessReference.
+     * Output images are allocated if their size or type does not match, views of regions are written in place.
+     * Gray image is skipped if aGray is null. Output images must not share memory with aFrame. Tiles are processed
+     * in the calling thread if aParallel is false, which is used when the caller is already a worker of a pool.
+     */
+    static void Process(const cv::Mat &aFrame, cv::Mat &aPreProcessed, cv::Mat *aGray = nullptr, bool aParallel = true);
+
+    //! Pre-processing by separate OpenCV functions, the output is the reference for FramePreProcessor#Process
+    static void ProcessReference(const cv::Mat &aFrame, cv::Mat &aPreProcessed, cv::Mat *aGray = nullptr);
+};
+
+#endif //__FRAMEPREPROCESSOR_HPP__
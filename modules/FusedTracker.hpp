@@ -0,0 +1,171 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration and implementation of class template FusedTracker
+ *
+ */
+
+#ifndef __FUSEDTRACKER_HPP__
+#define __FUSEDTRACKER_HPP__
+
+#include <opencv2/core/core.hpp>
+
+#include "TrackerBase.hpp"
+#include "ModifiedKalmanFilter.hpp"
+#include "MapBasedTracker.hpp"
+#include "BatchedKalmanFilter.hpp"
+#include "MultipleTracker.hpp"
+#include "TrackingContext.hpp"
+
+/*!
+ * \brief Sub-tracker of FusedTracker constructed from the context
+ *
+ * Trackers without state in the context are constructed by default constructor.
+ */
+template<typename Tracker>
+struct FusedElement
+{
+    Tracker Element;
+
+    explicit FusedElement(TrackingContext *) {}
+};
+
+//! BatchedKalmanFilter takes a slot in the engine of its model
+template<enum KalmanFilterType ModelType>
+struct FusedElement<BatchedKalmanFilter<ModelType>>
+{
+    BatchedKalmanFilter<ModelType> Element;
+
+    explicit FusedElement(TrackingContext *aContext) : Element(aContext->GetEngine<ModelType>()) {}
+};
+
+//! MapBasedTracker uses map of the context
+template<>
+struct FusedElement<MapBasedTracker>
+{
+    MapBasedTracker Element;
+
+    explicit FusedElement(TrackingContext *aContext) : Element(aContext != nullptr ? aContext->GetMap() : nullptr) {}
+};
+
+/*!
+ * \brief Sub-trackers of FusedTracker stored by value one after another
+ *
+ * Methods are called with qualified names, so there is no virtual dispatch and the compiler may inline them.
+ */
+template<typename... Trackers>
+struct FusedElements;
+
+template<>
+struct FusedElements<>
+{
+    explicit FusedElements(TrackingContext *) {}
+
+    void SetInitialPosition(cv::Point) {}
+    void Predict(double) {}
+    void Correct(cv::Point) {}
+    void AddPredictedCenters(cv::Point &, double) const {}
+};
+
+template<typename First, typename... Rest>
+struct FusedElements<First, Rest...>
+{
+    FusedElement<First> Head;
+    FusedElements<Rest...> Tail;
+
+    explicit FusedElements(TrackingContext *aContext) : Head(aContext), Tail(aContext) {}
+
+    void SetInitialPosition(cv::Point aCenter)
+    {
+        Head.Element.First::SetInitialPosition(aCenter);
+        Tail.SetInitialPosition(aCenter);
+    }
+
+    void Predict(double aAngle)
+    {
+        Head.Element.First::Predict(aAngle);
+        Tail.Predict(aAngle);
+    }
+
+    void Correct(cv::Point aCenter)
+    {
+        Head.Element.First::Correct(aCenter);
+        Tail.Correct(aCenter);
+    }
+
+    //! Add weighted predicted centers in the same order as MultipleTracker
+    void AddPredictedCenters(cv::Point &aCenter, double aCoefficient) const
+    {
+        aCenter += aCoefficient*Head.Element.First::GetPredictedCenter();
+        Tail.AddPredictedCenters(aCenter, aCoefficient);
+    }
+};
+
+/*!
+ * \class FusedTracker
+ * \brief Tracker composed of sub-trackers given by template arguments, e.g. FusedTracker<KalmanCV, KalmanCA, MapBased>
+ *
+ * It works as MultipleTracker, every call is forwarded to all sub-trackers and the predicted center is the average
+ * of their predicted centers. Sub-trackers are stored by value, so the whole stack is one allocation (one block of
+ * the tracker pool of TrackingContext) and there is one virtual call per object instead of one per sub-tracker.
+ *
+ * Corrected center is the average of predicted centers too, as in MultipleTracker.
+ */
+template<typename... Trackers>
+class FusedTracker : public TrackerBase
+{
+private:
+    static_assert(sizeof...(Trackers) > 0, "FusedTracker needs at least one sub-tracker");
+
+    FusedElements<Trackers...> iTrackers;
+
+public:
+    /// Constructor, context is needed by sub-trackers of type BatchedKalmanFilter and MapBasedTracker
+    explicit FusedTracker(TrackingContext *aContext = nullptr) : iTrackers(aContext) {}
+
+    FusedTracker(const FusedTracker &) = delete;
+    FusedTracker &operator=(const FusedTracker &) = delete;
+
+    void SetInitialPosition(cv::Point aCenter) { iTrackers.SetInitialPosition(aCenter); }
+
+    void Predict(double aAngle) { iTrackers.Predict(aAngle); }
+
+    void Correct(cv::Point aCenter) { iTrackers.Correct(aCenter); }
+
+    cv::Point GetPredictedCenter() const
+    {
+        cv::Point center;
+        iTrackers.AddPredictedCenters(center, 1.0/(double)(sizeof...(Trackers)));
+        return center;
+    }
+
+    cv::Point GetCorrectedCenter() const { return GetPredictedCenter(); }
+};
+
+/*!
+ * \brief Topologies of MultipleTracker as fused trackers
+ *
+ * FusedTopology<Type>::Batched uses filters stored in TrackingContext, FusedTopology<Type>::Standalone
+ * uses filters with their own state and needs no context.
+ */
+template<enum MultipleTrackerType Type>
+struct FusedTopology;
+
+template<>
+struct FusedTopology<E_singleKalman_singleMap>
+{
+    typedef FusedTracker<BatchedKalmanFilter<E_constant_velocity>, MapBasedTracker> Batched;
+    typedef FusedTracker<ModifiedKalmanFilter<E_constant_velocity>, MapBasedTracker> Standalone;
+};
+
+template<>
+struct FusedTopology<E_doubleKalman_singleMap>
+{
+    typedef FusedTracker<BatchedKalmanFilter<E_constant_velocity>, BatchedKalmanFilter<E_constant_acceleration>,
+            MapBasedTracker> Batched;
+    typedef FusedTracker<ModifiedKalmanFilter<E_constant_velocity>, ModifiedKalmanFilter<E_constant_acceleration>,
+            MapBasedTracker> Standalone;
+};
+
+#endif //__FUSEDTRACKER_HPP__
@@ -0,0 +1,257 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+
+#include "KalmanEngine.hpp"
+
+template<int StateSize>
+KalmanEngine<StateSize>::KalmanEngine(float aTimeStep, float aProcessNoise, float aMeasurementNoise, float aErrorCovariance) :
+        iTimeStep(aTimeStep),
+        iProcessNoise(aProcessNoise),
+        iMeasurementNoise(aMeasurementNoise),
+        iErrorCovariance(aErrorCovariance),
+        iSlotCount(0),
+        iMeasuredCount(0)
+{
+
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::Resize(size_t aSlotCount)
+{
+    for(int i = 0; i < StateSize; ++i)
+    {
+        iStatePre[i].resize(aSlotCount);
+        iStatePost[i].resize(aSlotCount);
+    }
+    for(int i = 0; i < StateSize*StateSize; ++i)
+        iErrorCov[i].resize(aSlotCount);
+    for(int i = 0; i < StateSize*2; ++i)
+        iGain[i].resize(aSlotCount);
+    for(int i = 0; i < StateSize; ++i)
+        iSecondRow[i].resize(aSlotCount);
+    for(int i = 0; i < 4; ++i)
+        iInverse[i].resize(aSlotCount);
+    iResidualX.resize(aSlotCount);
+    iResidualY.resize(aSlotCount);
+    iMeasurementX.resize(aSlotCount);
+    iMeasurementY.resize(aSlotCount);
+    iMeasured.resize(aSlotCount, 0);
+    iSlotCount = aSlotCount;
+}
+
+template<int StateSize>
+size_t KalmanEngine<StateSize>::AddTrack()
+{
+    size_t slot;
+    if(!iFreeSlots.empty())
+    {
+        slot = iFreeSlots.back();
+        iFreeSlots.pop_back();
+    }else{
+        slot = iSlotCount;
+        Resize(iSlotCount + 1);
+    }
+
+    for(int i = 0; i < StateSize; ++i)
+        iStatePre[i][slot] = iStatePost[i][slot] = 0;
+    for(int i = 0; i < StateSize; ++i)
+    {
+        for(int j = 0; j < StateSize; ++j)
+            iErrorCov[i*StateSize + j][slot] = i == j ? iErrorCovariance : 0.0f;
+    }
+    iMeasured[slot] = 0;
+    return slot;
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::RemoveTrack(size_t aSlot)
+{
+    if(iMeasured[aSlot])
+    {
+        iMeasured[aSlot] = 0;
+        --iMeasuredCount;
+    }
+    iFreeSlots.push_back(aSlot);
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::SetPosition(size_t aSlot, float aX, float aY)
+{
+    iStatePre[0][aSlot] = iStatePost[0][aSlot] = aX;
+    iStatePre[1][aSlot] = iStatePost[1][aSlot] = aY;
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::SetMeasurement(size_t aSlot, float aX, float aY)
+{
+    if(!iMeasured[aSlot])
+    {
+        iMeasured[aSlot] = 1;
+        ++iMeasuredCount;
+    }
+    iMeasurementX[aSlot] = aX;
+    iMeasurementY[aSlot] = aY;
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::PredictAll()
+{
+    //Free slots are predicted too, it is cheaper than skipping them
+    const size_t count = iSlotCount;
+    const float T = iTimeStep;
+    const float q = iProcessNoise;
+
+    //x = F*x
+    for(int i = 0; i < StateSize - 2; ++i)
+    {
+        float *pre = iStatePre[i].data();
+        const float *post = iStatePost[i].data();
+        const float *derivative = iStatePost[i + 2].data();
+        for(size_t s = 0; s < count; ++s)
+            pre[s] = post[s] + T*derivative[s];
+    }
+    for(int i = StateSize - 2; i < StateSize; ++i)
+        std::copy(iStatePost[i].begin(), iStatePost[i].end(), iStatePre[i].begin());
+
+    //P = F*P*F' + Q, element (i,j) is P(i,j) + T*P(i+2,j) + T*(P(i,j+2) + T*P(i+2,j+2)) without missing terms.
+    //Elements are computed in place in ascending order, so they read only elements which were not updated yet.
+    for(int i = 0; i < StateSize; ++i)
+    {
+        for(int j = 0; j < StateSize; ++j)
+        {
+            float *p = iErrorCov[i*StateSize + j].data();
+            const float noise = i == j ? q : 0.0f;
+            if(i < StateSize - 2 && j < StateSize - 2)
+            {
+                const float *p_i2 = iErrorCov[(i + 2)*StateSize + j].data();
+                const float *p_j2 = iErrorCov[i*StateSize + j + 2].data();
+                const float *p_ij2 = iErrorCov[(i + 2)*StateSize + j + 2].data();
+                for(size_t s = 0; s < count; ++s)
+                    p[s] = ((p[s] + T*p_i2[s]) + T*(p_j2[s] + T*p_ij2[s])) + noise;
+            }else if(i < StateSize - 2){
+                const float *p_i2 = iErrorCov[(i + 2)*StateSize + j].data();
+                for(size_t s = 0; s < count; ++s)
+                    p[s] = (p[s] + T*p_i2[s]) + noise;
+            }else if(j < StateSize - 2){
+                const float *p_j2 = iErrorCov[i*StateSize + j + 2].data();
+                for(size_t s = 0; s < count; ++s)
+                    p[s] = (p[s] + T*p_j2[s]) + noise;
+            }else if(i == j){
+                for(size_t s = 0; s < count; ++s)
+                    p[s] = p[s] + noise;
+            }
+        }
+    }
+
+    for(int i = 0; i < StateSize; ++i)
+        std::copy(iStatePre[i].begin(), iStatePre[i].end(), iStatePost[i].begin());
+}
+
+template<int StateSize>
+void KalmanEngine<StateSize>::CorrectAll()
+{
+    if(iMeasuredCount == 0)
+        return;
+
+    //All slots are computed, tracks without measurement get zero gain
+    const size_t count = iSlotCount;
+    const double r = iMeasurementNoise;
+    const int *measured = iMeasured.data();
+
+    //Inverse of H*P*H' + R, which is the top left 2x2 block of P with noise on the diagonal
+    {
+        const float *p00 = iErrorCov[0].data();
+        const float *p01 = iErrorCov[1].data();
+        const float *p10 = iErrorCov[StateSize].data();
+        const float *p11 = iErrorCov[StateSize + 1].data();
+        double *i00 = iInverse[0].data(), *i01 = iInverse[1].data();
+        double *i10 = iInverse[2].data(), *i11 = iInverse[3].data();
+        for(size_t s = 0; s < count; ++s)
+        {
+            const double s00 = double(p00[s]) + r;
+            const double s11 = double(p11[s]) + r;
+            const double inverse_determinant = 1.0/(s00*s11 - double(p01[s])*double(p10[s]));
+            i00[s] = s11*inverse_determinant;
+            i01[s] = -double(p01[s])*inverse_determinant;
+            i10[s] = -double(p10[s])*inverse_determinant;
+            i11[s] = s00*inverse_determinant;
+        }
+    }
+
+    //K = P*H'*(H*P*H' + R)^-1
+    for(int i = 0; i < StateSize; ++i)
+    {
+        const float *p0 = iErrorCov[i*StateSize].data();
+        const float *p1 = iErrorCov[i*StateSize + 1].data();
+        const double *i00 = iInverse[0].data(), *i01 = iInverse[1].data();
+        const double *i10 = iInverse[2].data(), *i11 = iInverse[3].data();
+        float *gain_x = iGain[2*i].data();
+        float *gain_y = iGain[2*i + 1].data();
+        for(size_t s = 0; s < count; ++s)
+        {
+            gain_x[s] = float(p0[s]*i00[s] + p1[s]*i10[s]);
+            gain_y[s] = float(p0[s]*i01[s] + p1[s]*i11[s]);
+        }
+        //Zero gain keeps state and covariance of the track without measurement, select of loaded values is
+        //vectorized unlike a conditional update of the state
+        for(size_t s = 0; s < count; ++s)
+            gain_x[s] = measured[s] ? gain_x[s] : 0.0f;
+        for(size_t s = 0; s < count; ++s)
+            gain_y[s] = measured[s] ? gain_y[s] : 0.0f;
+    }
+
+    float *residual_x = iResidualX.data();
+    float *residual_y = iResidualY.data();
+    {
+        const float *measurement_x = iMeasurementX.data();
+        const float *measurement_y = iMeasurementY.data();
+        const float *pre_x = iStatePre[0].data();
+        const float *pre_y = iStatePre[1].data();
+        for(size_t s = 0; s < count; ++s)
+        {
+            residual_x[s] = measurement_x[s] - pre_x[s];
+            residual_y[s] = measurement_y[s] - pre_y[s];
+        }
+    }
+
+    //x = x + K*(z - H*x)
+    for(int i = 0; i < StateSize; ++i)
+    {
+        const float *gain_x = iGain[2*i].data();
+        const float *gain_y = iGain[2*i + 1].data();
+        const float *pre = iStatePre[i].data();
+        float *post = iStatePost[i].data();
+        for(size_t s = 0; s < count; ++s)
+        {
+            post[s] = pre[s] + gain_x[s]*residual_x[s] + gain_y[s]*residual_y[s];
+        }
+    }
+
+    //P = P - K*H*P, H*P are the first two rows of P. Rows are updated in place from the last one, only the
+    //second row is needed by the first row after it was updated.
+    for(int j = 0; j < StateSize; ++j)
+        std::copy(iErrorCov[StateSize + j].begin(), iErrorCov[StateSize + j].end(), iSecondRow[j].begin());
+    for(int i = StateSize - 1; i >= 0; --i)
+    {
+        const float *gain_x = iGain[2*i].data();
+        const float *gain_y = iGain[2*i + 1].data();
+        for(int j = 0; j < StateSize; ++j)
+        {
+            float *p = iErrorCov[i*StateSize + j].data();
+            const float *p0 = iErrorCov[j].data();
+            const float *p1 = iSecondRow[j].data();
+            for(size_t s = 0; s < count; ++s)
+                p[s] = p[s] - (gain_x[s]*p0[s] + gain_y[s]*p1[s]);
+        }
+    }
+
+    std::fill(iMeasured.begin(), iMeasured.end(), 0);
+    iMeasuredCount = 0;
+}
+
+template class KalmanEngine<4>;
+template class KalmanEngine<6>;
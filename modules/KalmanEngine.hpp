@@ -0,0 +1,92 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class template KalmanEngine
+ *
+ */
+
+#ifndef __KALMANENGINE_HPP__
+#define __KALMANENGINE_HPP__
+
+#include <vector>
+#include <cstddef>
+
+/*!
+ * \class KalmanEngine
+ * \brief Kalman filters of all tracks with the same model stored as structure of arrays
+ *
+ * Model is the same as in FixedKalmanFilter. Every element of state vectors and covariance matrices is stored
+ * in its own array indexed by slot of the track, so KalmanEngine#PredictAll and KalmanEngine#CorrectAll are
+ * simple loops over contiguous arrays which the compiler vectorizes. Arithmetic is done in the same order as in
+ * FixedKalmanFilter, so the results are identical (checked by Kalman test).
+ *
+ * Measurements are only stored by KalmanEngine#SetMeasurement, the corrected state is updated for all measured
+ * tracks at once by KalmanEngine#CorrectAll. Predicted state is not changed by the correction, corrected state
+ * of a track without measurement stays equal to the predicted state.
+ */
+template<int StateSize>
+class KalmanEngine
+{
+private:
+    static_assert(StateSize >= 4 && StateSize % 2 == 0, "State must contain position and its derivatives");
+
+    float iTimeStep, iProcessNoise, iMeasurementNoise, iErrorCovariance;
+
+    size_t iSlotCount;
+    std::vector<size_t> iFreeSlots;
+
+    //! Element i of state of slot s is iStatePre[i][s], element (i,j) of covariance is iErrorCov[i*StateSize+j][s]
+    std::vector<float> iStatePre[StateSize], iStatePost[StateSize];
+    //! Covariance is updated in place, predicted covariance is not needed after correction
+    std::vector<float> iErrorCov[StateSize*StateSize];
+
+    std::vector<float> iMeasurementX, iMeasurementY;
+    std::vector<int> iMeasured;             ///< Not char, which could alias the float arrays and stop vectorization
+    size_t iMeasuredCount;
+
+    //Buffers of CorrectAll
+    std::vector<double> iInverse[4];
+    std::vector<float> iGain[StateSize*2], iResidualX, iResidualY, iSecondRow[StateSize];
+
+    void Resize(size_t aSlotCount);
+
+public:
+    //! Constructor with parameters of the model (see FixedKalmanFilter)
+    KalmanEngine(float aTimeStep, float aProcessNoise, float aMeasurementNoise, float aErrorCovariance);
+
+    KalmanEngine(const KalmanEngine &) = delete;
+    KalmanEngine &operator=(const KalmanEngine &) = delete;
+
+    //! Return slot of a new track with zero state and initial covariance
+    size_t AddTrack();
+
+    //! Free slot of a track, pending measurement is dropped
+    void RemoveTrack(size_t aSlot);
+
+    //! Set position in predicted and corrected state
+    void SetPosition(size_t aSlot, float aX, float aY);
+
+    //! Store measurement of the track for the next KalmanEngine#CorrectAll
+    void SetMeasurement(size_t aSlot, float aX, float aY);
+
+    //! Predict state of all tracks
+    void PredictAll();
+
+    //! Correct state of all tracks with a measurement
+    void CorrectAll();
+
+    //! Return element of state after prediction
+    float GetStatePre(size_t aSlot, int aIndex) const { return iStatePre[aIndex][aSlot]; }
+
+    //! Return element of state after correction
+    float GetStatePost(size_t aSlot, int aIndex) const { return iStatePost[aIndex][aSlot]; }
+
+    //! Return number of tracks
+    size_t GetTrackCount() const { return iSlotCount - iFreeSlots.size(); }
+};
+
+extern template class KalmanEngine<4>;
+extern template class KalmanEngine<6>;
+
+#endif //__KALMANENGINE_HPP__
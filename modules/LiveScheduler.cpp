@@ -0,0 +1,78 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <thread>
+#include <algorithm>
+
+#include "LiveScheduler.hpp"
+
+LiveScheduler::LiveScheduler(double aFrameRate, double aLatencyBudget, unsigned int aMaxSkippedInRow) :
+        iStart(Clock::now()),
+        iFrameInterval(1.0/(aFrameRate > 0 ? aFrameRate : 25.0)),
+        iLatencyBudget(aLatencyBudget),
+        iMaxSkippedInRow(aMaxSkippedInRow),
+        iSkippedInRow(0),
+        iFrameIndex(0),
+        iSkippedFrames(0),
+        iAnalysing(false),
+        iAnalysisTime(0),
+        iMaxLatency(0),
+        iLatencySum(0)
+{
+
+}
+
+void LiveScheduler::Start()
+{
+    iStart = Clock::now();
+    iFrameIndex = 0;
+    iSkippedFrames = 0;
+    iSkippedInRow = 0;
+    iAnalysing = false;
+    iMaxLatency = 0;
+    iLatencySum = 0;
+}
+
+double LiveScheduler::CurrentDelay() const
+{
+    return std::chrono::duration<double>(Clock::now() - iStart).count() - iFrameIndex*iFrameInterval;
+}
+
+bool LiveScheduler::AnalyseNextFrame()
+{
+    double delay = CurrentDelay();
+    if(delay < 0)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double>(-delay));
+        delay = 0;
+    }
+
+    if(delay + iAnalysisTime > iLatencyBudget && iSkippedInRow < iMaxSkippedInRow)
+    {
+        ++iSkippedInRow;
+        ++iSkippedFrames;
+        iAnalysing = false;
+        return(false);
+    }
+    iSkippedInRow = 0;
+    iAnalysing = true;
+    iAnalysisStart = Clock::now();
+    return(true);
+}
+
+void LiveScheduler::FrameDone()
+{
+    if(iAnalysing)
+    {
+        const double analysis_time = std::chrono::duration<double>(Clock::now() - iAnalysisStart).count();
+        iAnalysisTime = iAnalysisTime > 0 ? 0.9*iAnalysisTime + 0.1*analysis_time : analysis_time;
+        iAnalysing = false;
+    }
+
+    const double latency = std::max(0.0, CurrentDelay());
+    iMaxLatency = std::max(iMaxLatency, latency);
+    iLatencySum += latency;
+    ++iFrameIndex;
+}
@@ -0,0 +1,78 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class LiveScheduler
+ *
+ */
+
+#ifndef __LIVESCHEDULER_HPP__
+#define __LIVESCHEDULER_HPP__
+
+#include <chrono>
+
+/*!
+ * \class LiveScheduler
+ * \brief Decides which frames of a live feed are analysed so the latency stays within a budget
+ *
+ * Frame i arrives at time i/fps after LiveScheduler#Start, so a video file is played as a camera. Latency of
+ * a frame is the time from its arrival to the end of its processing. Before every frame
+ * LiveScheduler#AnalyseNextFrame adds the average time of analysis of a frame to the current delay of the frame.
+ * Frame which would miss the latency budget is skipped: it is only decoded and the tracked objects are moved
+ * by prediction, which is much cheaper, so processing catches up. At most iMaxSkippedInRow frames are skipped
+ * in a row, so tracks are corrected regularly even under a permanent overload. Frames arriving early are
+ * waited for.
+ */
+class LiveScheduler
+{
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    Clock::time_point iStart;
+    double iFrameInterval;      ///< Seconds between arrivals of frames
+    double iLatencyBudget;      ///< Seconds
+    unsigned int iMaxSkippedInRow;
+    unsigned int iSkippedInRow;
+    unsigned long iFrameIndex;
+    unsigned long iSkippedFrames;
+    bool iAnalysing;
+    Clock::time_point iAnalysisStart;
+    double iAnalysisTime;       ///< Moving average of time of analysis of a frame in seconds
+    double iMaxLatency, iLatencySum;
+
+    //! Seconds since arrival of the current frame, negative if it has not arrived yet
+    double CurrentDelay() const;
+
+public:
+    /*!
+     * \brief Constructor
+     *
+     * \param aFrameRate Frames per second of the feed, 25 is used if it is not positive
+     * \param aLatencyBudget Maximal latency of a frame in seconds
+     * \param aMaxSkippedInRow Maximal number of frames skipped in a row, 0 turns off skipping
+     */
+    LiveScheduler(double aFrameRate, double aLatencyBudget, unsigned int aMaxSkippedInRow);
+
+    //! Set arrival time of the first frame to now
+    void Start();
+
+    //! Wait for arrival of the next frame and return false if it is to be skipped
+    bool AnalyseNextFrame();
+
+    //! Mark processing of the current frame as finished
+    void FrameDone();
+
+    //! Return number of finished frames
+    unsigned long GetFrameCount() const { return iFrameIndex; }
+
+    //! Return number of skipped frames
+    unsigned long GetSkippedFrames() const { return iSkippedFrames; }
+
+    //! Return maximal latency of a frame in seconds
+    double GetMaxLatency() const { return iMaxLatency; }
+
+    //! Return average latency of a frame in seconds
+    double GetAverageLatency() const { return iFrameIndex > 0 ? iLatencySum/iFrameIndex : 0.0; }
+};
+
+#endif //__LIVESCHEDULER_HPP__
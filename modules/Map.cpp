@@ -6,6 +6,17 @@
 #include <iostream>
 #include <fstream>
 #include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <cstdio>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <opencv2/highgui/highgui.hpp>
 
@@ -13,47 +24,163 @@
 
 #define __MIN_COMPILER_14 (__cplusplus >= 201402L) ///< C++14 is needed for generic lambdas
 
-void Map::AllocateVelocityMatrix()
+namespace
 {
-    // Create 3D velocity matrix
-    iVelocityMatrix = new struct MapCell **[4];
+    const char MAP_FILE_MAGIC[8] = {'O', 'T', 'V', 'M', 'A', 'P', '\0', '\0'};
+    const uint32_t MAP_FILE_VERSION = 2;
+    const uint32_t MAP_FILE_DENSE_VERSION = 1;     ///< Version without tile table, still readable
+
+    /*!
+     * \brief Header of binary map file
+     *
+     * Header is followed by table of indices of stored tiles (sorted, padded to cache line) and by the tiles
+     * in the same form as they are stored in memory, so the file can be mapped to memory directly. Dense map
+     * is stored as one tile. Size of header is one cache line, so the cells stay aligned. All numbers are
+     * stored in native byte order.
+     */
+    struct MapFileHeader
+    {
+        char Magic[8];
+        uint32_t Version;
+        uint32_t Height, Width, Grid;
+        uint32_t Directions;
+        uint32_t Layout;
+        uint32_t CellSize;
+        uint32_t Encoding;
+        uint64_t DataSize;      ///< Size of tile table and tiles in bytes
+        uint64_t Checksum;      ///< FNV-1a hash of tile table and tiles computed over 64-bit words
+        uint32_t TileSize;      ///< Side of tile in cells, 0 for dense map
+        uint32_t TileCount;     ///< Number of stored tiles
+    };
+
+    const uint64_t CHECKSUM_SEED = 14695981039346656037ULL;
+
+    //! Size of tile table in file
+    uint64_t TileTableBytes(uint64_t aTileCount)
+    {
+        return (aTileCount*sizeof(uint32_t) + 63) & ~uint64_t(63);
+    }
+
+    static_assert(sizeof(MapFileHeader) == 64, "Header of map file must fill one cache line");
+    static_assert(sizeof(MapCell) % sizeof(uint64_t) == 0, "Map cell must be multiple of 64-bit words");
+    static_assert(sizeof(MapCellFloat) % sizeof(uint64_t) == 0, "Map cell must be multiple of 64-bit words");
+    static_assert(sizeof(MapCellFixed16) == 16, "Four fixed point cells must fill one cache line");
+
+    const double VELOCITY_SCALE = 256.0;        ///< Q8.8
+    const double MEAN_SQUARE_SCALE = 65536.0;   ///< Q16.16
+
+    int16_t EncodeVelocity(double aValue)
+    {
+        double value = std::round(aValue*VELOCITY_SCALE);
+        return int16_t(std::min(32767.0, std::max(-32768.0, value)));
+    }
 
-    for (unsigned int i = 0; i < 4; ++i)
+    uint32_t EncodeMeanSquare(double aValue)
     {
-        iVelocityMatrix[i] = new struct MapCell *[iHeight];
-        for(unsigned int j=0; j<iHeight; ++j)
+        double value = std::round(aValue*MEAN_SQUARE_SCALE);
+        return uint32_t(std::min(4294967295.0, std::max(0.0, value)));
+    }
+
+    uint64_t CalcChecksum(const void *aData, size_t aSize, uint64_t aHash = CHECKSUM_SEED)
+    {
+        const uint64_t *words = static_cast<const uint64_t *>(aData);
+        uint64_t hash = aHash;
+        for(size_t i = 0; i < aSize/sizeof(uint64_t); ++i)
         {
-            iVelocityMatrix[i][j] = new struct MapCell[iWidth];
-            for(unsigned int k=0; k<iWidth; ++k)
-            {
-                iVelocityMatrix[i][j][k].Velocity.real(0);
-                iVelocityMatrix[i][j][k].Velocity.imag(0);
-                iVelocityMatrix[i][j][k].Counter = 0;
-            }
+            hash ^= words[i];
+            hash *= 1099511628211ULL;
         }
+        return hash;
+    }
+}
+
+void Map::SetupTiles()
+{
+    if(iTileSize == 0)
+    {
+        iTileShift = 0;
+        iTileHeight = iHeight;
+        iTileWidth = iWidth;
+        iTileRows = iTileColumns = 1;
+    }else{
+        iTileShift = 0;
+        while((1u << iTileShift) < iTileSize)
+            ++iTileShift;
+        iTileHeight = iTileWidth = iTileSize;
+        iTileRows = (iHeight + iTileSize - 1) >> iTileShift;
+        iTileColumns = (iWidth + iTileSize - 1) >> iTileShift;
     }
+    iTiles.assign(size_t(iTileRows)*iTileColumns, nullptr);
+    ClearChanges();
+}
+
+void Map::AllocateVelocityMatrix()
+{
+    SetupTiles();
+
+    // Dense map is one block of memory allocated in advance, tiles of sparse map are allocated on first write
+    if(iTileSize == 0)
+        iTiles[0] = AllocateTile();
     //dbg: std::cout << "w: " << iWidth << ", h: " << iHeight << std::endl;
 }
 
+unsigned char *Map::AllocateTile() const
+{
+    const size_t size = TileBytes();
+    void *memory = nullptr;
+    if(posix_memalign(&memory, 64, std::max<size_t>(size, 1)) != 0)
+        throw std::bad_alloc();
+
+    //Zero bytes represent empty cell in all encodings, padding is zeroed too, so the cells can be saved byte by byte
+    std::memset(memory, 0, size);
+    return static_cast<unsigned char *>(memory);
+}
+
+bool Map::IsMappedTile(const unsigned char *aTile) const
+{
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(iMappedFile);
+    const uintptr_t tile = reinterpret_cast<uintptr_t>(aTile);
+    return iMappedFile != nullptr && tile >= begin && tile < begin + iMappedSize;
+}
+
 void Map::DeleteVelocityMatrix()
 {
-    if(iVelocityMatrix == nullptr)
-        return;
+    //Tiles written after the file was mapped are allocated on heap
+    for(unsigned char *tile : iTiles)
+    {
+        if(!IsMappedTile(tile))
+            std::free(tile);
+    }
+    iTiles.clear();
 
-    for (unsigned int i = 0; i < 4; ++i)
+    if(iMappedFile != nullptr)
     {
-        for(unsigned int j=0; j<iHeight; ++j)
-        {
-            delete(iVelocityMatrix[i][j]);
-        }
-        delete(iVelocityMatrix[i]);
+        munmap(iMappedFile, iMappedSize);
+        iMappedFile = nullptr;
+        iMappedSize = 0;
     }
-    delete(iVelocityMatrix);
 }
 
 //unsigned int aHeight=480, unsigned int aWidth=640, unsigned int aGrid=5
-Map::Map(unsigned int aHeight, unsigned int aWidth, unsigned int aGrid) : iGrid(aGrid)
+Map::Map(unsigned int aHeight, unsigned int aWidth, unsigned int aGrid, MapLayout aLayout, MapCellEncoding aEncoding,
+         unsigned int aTileSize) :
+        iMappedFile(nullptr),
+        iMappedSize(0),
+        iLayout(aLayout),
+        iEncoding(aEncoding),
+        iCellSize(CellSize(aEncoding)),
+        iFileFormat(E_text_map_file),
+        iTileSize(0),
+        iGrid(aGrid),
+        iTrackChanges(false),
+        iPlotWindowOpened(false)
 {
+    if(aTileSize != 0)
+    {
+        iTileSize = 1;
+        while(iTileSize < aTileSize)
+            iTileSize <<= 1;
+    }
     iHeight = (unsigned int)(floor(double(aHeight)/aGrid + 0.5));
     iWidth = (unsigned int)(floor(double(aWidth)/aGrid + 0.5));
     AllocateVelocityMatrix();
@@ -64,6 +191,125 @@ Map::~Map()
     DeleteVelocityMatrix();
 }
 
+size_t Map::GetPopulatedTiles() const
+{
+    return size_t(std::count_if(iTiles.begin(), iTiles.end(), [](const unsigned char *aTile) { return aTile != nullptr; }));
+}
+
+size_t Map::CellSize(MapCellEncoding aEncoding)
+{
+    switch(aEncoding)
+    {
+        case E_float_cell:
+            return sizeof(MapCellFloat);
+        case E_fixed16_cell:
+            return sizeof(MapCellFixed16);
+        default:
+            return sizeof(MapCell);
+    }
+}
+
+MapCell Map::ReadCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const
+{
+    const unsigned char *data = FindCell(aDirection, aRow, aColumn);
+    MapCell cell;
+
+    if(data == nullptr)
+    {
+        cell.Velocity = std::complex<double>(0, 0);
+        cell.Counter = 0;
+        cell.mean_square_x = cell.mean_square_y = 0;
+        return cell;
+    }
+
+    switch(iEncoding)
+    {
+        case E_float_cell:
+        {
+            const MapCellFloat &stored = *reinterpret_cast<const MapCellFloat *>(data);
+            cell.Velocity = std::complex<double>(stored.Velocity.real(), stored.Velocity.imag());
+            cell.Counter = stored.Counter;
+            cell.mean_square_x = stored.mean_square_x;
+            cell.mean_square_y = stored.mean_square_y;
+            break;
+        }
+        case E_fixed16_cell:
+        {
+            const MapCellFixed16 &stored = *reinterpret_cast<const MapCellFixed16 *>(data);
+            cell.Velocity = std::complex<double>(stored.VelocityX/VELOCITY_SCALE, stored.VelocityY/VELOCITY_SCALE);
+            cell.Counter = stored.Counter;
+            cell.mean_square_x = stored.MeanSquareX/MEAN_SQUARE_SCALE;
+            cell.mean_square_y = stored.MeanSquareY/MEAN_SQUARE_SCALE;
+            break;
+        }
+        default:
+            cell = *reinterpret_cast<const MapCell *>(data);
+    }
+
+    return cell;
+}
+
+void Map::WriteCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn, const MapCell &aCell)
+{
+    if(iTrackChanges)
+        MarkChanged(aRow, aColumn);
+    unsigned char *data = GetCell(aDirection, aRow, aColumn);
+
+    switch(iEncoding)
+    {
+        case E_float_cell:
+        {
+            MapCellFloat &stored = *reinterpret_cast<MapCellFloat *>(data);
+            stored.Velocity = std::complex<float>(float(aCell.Velocity.real()), float(aCell.Velocity.imag()));
+            stored.Counter = aCell.Counter;
+            stored.mean_square_x = float(aCell.mean_square_x);
+            stored.mean_square_y = float(aCell.mean_square_y);
+            break;
+        }
+        case E_fixed16_cell:
+        {
+            MapCellFixed16 &stored = *reinterpret_cast<MapCellFixed16 *>(data);
+            stored.VelocityX = EncodeVelocity(aCell.Velocity.real());
+            stored.VelocityY = EncodeVelocity(aCell.Velocity.imag());
+            stored.Counter = uint16_t(std::min(aCell.Counter, 65535u));
+            stored.MeanSquareX = EncodeMeanSquare(aCell.mean_square_x);
+            stored.MeanSquareY = EncodeMeanSquare(aCell.mean_square_y);
+            break;
+        }
+        default:
+        {
+            MapCell &stored = *reinterpret_cast<MapCell *>(data);
+            stored.Velocity = aCell.Velocity;
+            stored.Counter = aCell.Counter;
+            stored.mean_square_x = aCell.mean_square_x;
+            stored.mean_square_y = aCell.mean_square_y;
+        }
+    }
+}
+
+std::complex<double> Map::ReadVelocity(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const
+{
+    const unsigned char *data = FindCell(aDirection, aRow, aColumn);
+    if(data == nullptr)
+        return std::complex<double>(0, 0);
+
+    switch(iEncoding)
+    {
+        case E_float_cell:
+        {
+            const std::complex<float> &velocity = reinterpret_cast<const MapCellFloat *>(data)->Velocity;
+            return std::complex<double>(velocity.real(), velocity.imag());
+        }
+        case E_fixed16_cell:
+        {
+            const MapCellFixed16 &stored = *reinterpret_cast<const MapCellFixed16 *>(data);
+            return std::complex<double>(stored.VelocityX/VELOCITY_SCALE, stored.VelocityY/VELOCITY_SCALE);
+        }
+        default:
+            return reinterpret_cast<const MapCell *>(data)->Velocity;
+    }
+}
+
 void Map::SetVelocityVector(unsigned int aXPosition, unsigned int aYPosition, double aXVelocity, double aYVelocity, double aDirection)
 {
     std::complex<double> newVector(aXVelocity, aYVelocity);
@@ -71,10 +317,19 @@ void Map::SetVelocityVector(unsigned int aXPosition, unsigned int aYPosition, do
     unsigned int x= (unsigned int)(floor(double(aXPosition)/iGrid ));
     unsigned int y= (unsigned int)(floor(double(aYPosition)/iGrid ));
 
+    if(x >= iWidth || y >= iHeight)
+        return;
+
     int direction = CalcDirection(aDirection);
+    MapCell cell = ReadCell(direction, y, x);
+    FilterCell(cell, newVector);
+    WriteCell(direction, y, x, cell);
+}
 
-    iVelocityMatrix[direction][y][x].Counter++;
-    const unsigned int N = iVelocityMatrix[direction][y][x].Counter;
+void Map::FilterCell(MapCell &aCell, const std::complex<double> &aVelocity)
+{
+    aCell.Counter++;
+    const unsigned int N = aCell.Counter;
     const double A = double(N-1)/N;
     const double B = double(1)/N;
     double tc = (N > 1) ? 0.02 : 0;
@@ -90,48 +345,176 @@ void Map::SetVelocityVector(unsigned int aXPosition, unsigned int aYPosition, do
         return (A-tc)*x_n_1 + (B+tc)*u_n;
     };
 
-    //iVelocityMatrix[direction][y][x].Velocity = A*iVelocityMatrix[direction][y][x].Velocity + B*newVector;
-    iVelocityMatrix[direction][y][x].Velocity = iir_filter(
-            iVelocityMatrix[direction][y][x].Velocity,
-            newVector);
-
-    iVelocityMatrix[direction][y][x].mean_square_x = iir_filter(
-            iVelocityMatrix[direction][y][x].mean_square_x,
-            pow(newVector.real(), 2));
-
-    iVelocityMatrix[direction][y][x].mean_square_y = iir_filter(
-            iVelocityMatrix[direction][y][x].mean_square_y,
-            pow(newVector.imag(), 2));
+    //aCell.Velocity = A*aCell.Velocity + B*aVelocity;
+    aCell.Velocity = iir_filter(aCell.Velocity, aVelocity);
+    aCell.mean_square_x = iir_filter(aCell.mean_square_x, aVelocity.real()*aVelocity.real());
+    aCell.mean_square_y = iir_filter(aCell.mean_square_y, aVelocity.imag()*aVelocity.imag());
 
     #else
         #pragma message "Compiling Map without C++14 features."
 
-        iVelocityMatrix[direction][y][x].Velocity = (A-tc)*iVelocityMatrix[direction][y][x].Velocity + (B+tc)*newVector;
-        iVelocityMatrix[direction][y][x].mean_square_x =
-            (A-tc)*iVelocityMatrix[direction][y][x].mean_square_x + (B+tc)*pow(newVector.real(), 2);
-        iVelocityMatrix[direction][y][x].mean_square_y =
-            (A-tc)*iVelocityMatrix[direction][y][x].mean_square_y + (B+tc)*pow(newVector.imag(), 2);
+        aCell.Velocity = (A-tc)*aCell.Velocity + (B+tc)*aVelocity;
+        aCell.mean_square_x = (A-tc)*aCell.mean_square_x + (B+tc)*aVelocity.real()*aVelocity.real();
+        aCell.mean_square_y = (A-tc)*aCell.mean_square_y + (B+tc)*aVelocity.imag()*aVelocity.imag();
 
     #endif
+}
+
+void Map::SetVelocityVectors(const std::vector<cv::Point2f> &aFrom, const std::vector<cv::Point2f> &aTo,
+        const std::vector<uchar> &aStatus)
+{
+    const size_t count = std::min(aFrom.size(), std::min(aTo.size(), aStatus.size()));
+    const uint32_t invalid_direction = iDirectionCount;
+    const int grid = int(iGrid);
+    const double inverse_grid = 1.0/iGrid;
+    const float position_limit = 1e9f;
+
+    iBatchColumns.resize(count);
+    iBatchRows.resize(count);
+    iBatchDirections.resize(count);
+    iBatchVelocity.resize(count);
+
+    //Cell of every feature, no branches so the loop can be vectorized
+    for(size_t i = 0; i < count; ++i)
+    {
+        const float dx = aTo[i].x - aFrom[i].x;
+        const float dy = aTo[i].y - aFrom[i].y;
+        //Positions are clamped, so lost features with any coordinates can be converted to integers (NaN gives -1)
+        const int x_position = int(std::min(position_limit, std::max(-1.0f, aFrom[i].x)));
+        const int y_position = int(std::min(position_limit, std::max(-1.0f, aFrom[i].y)));
+        //Quotient by the reciprocal is corrected by one in both directions, so it equals floor(position/grid)
+        int x = int(x_position*inverse_grid);
+        int y = int(y_position*inverse_grid);
+        x += int((x + 1)*grid <= x_position) - int(x*grid > x_position);
+        y += int((y + 1)*grid <= y_position) - int(y*grid > y_position);
+
+        //Same bins as CalcDirection(CalcAngle(dy, dx))
+        const uint32_t direction = uint32_t(dx < 0)*2 + uint32_t(dx == 0)*(3 - 2*uint32_t(dy > 0));
+
+        const bool valid = aStatus[i] != 0 && x_position >= 0 && y_position >= 0 && x < int(iWidth) && y < int(iHeight) &&
+                dx == dx && dy == dy;
+        iBatchColumns[i] = uint32_t(x);
+        iBatchRows[i] = uint32_t(y);
+        iBatchDirections[i] = valid ? direction : invalid_direction;
+        iBatchVelocity[i] = std::complex<double>(dx, dy);
+    }
+
+    //Updates are applied in order of features, so more features in one cell give the same result as single updates
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(iBatchDirections[i] == invalid_direction)
+            continue;
+        MapCell cell = ReadCell(iBatchDirections[i], iBatchRows[i], iBatchColumns[i]);
+        FilterCell(cell, iBatchVelocity[i]);
+        WriteCell(iBatchDirections[i], iBatchRows[i], iBatchColumns[i], cell);
+    }
+}
+
+void Map::SetChangeTracking(bool aEnabled)
+{
+    iTrackChanges = aEnabled;
+    ClearChanges();
+}
+
+void Map::ClearChanges()
+{
+    iChangedCells.clear();
+    if(iTrackChanges)
+        iChangedFlags.assign(size_t(iHeight)*iWidth, 0);
+    else
+        std::vector<uint8_t>().swap(iChangedFlags);
+}
+
+std::unique_ptr<Map> Map::Clone() const
+{
+    std::unique_ptr<Map> copy(new Map(iHeight*iGrid, iWidth*iGrid, iGrid, iLayout, iEncoding, iTileSize));
+    copy->iFileName = iFileName;
+    copy->iFileFormat = iFileFormat;
+    for(size_t i = 0; i < iTiles.size(); ++i)
+    {
+        if(iTiles[i] == nullptr)
+            continue;
+        if(copy->iTiles[i] == nullptr)
+            copy->iTiles[i] = copy->AllocateTile();
+        std::memcpy(copy->iTiles[i], iTiles[i], TileBytes());
+    }
+    return copy;
+}
 
+bool Map::CopyChangedCells(Map &aTarget)
+{
+    if(aTarget.iHeight != iHeight || aTarget.iWidth != iWidth || aTarget.iGrid != iGrid || aTarget.iLayout != iLayout ||
+            aTarget.iEncoding != iEncoding || aTarget.iTileSize != iTileSize)
+        return(false);
+
+    //Cells are copied byte by byte, both maps have the same format
+    for(const uint32_t index : iChangedCells)
+    {
+        const unsigned int row = index/iWidth;
+        const unsigned int column = index % iWidth;
+        for(unsigned int i = 0; i < iDirectionCount; ++i)
+        {
+            const unsigned char *cell = FindCell(i, row, column);
+            if(cell != nullptr)
+                std::memcpy(aTarget.GetCell(i, row, column), cell, iCellSize);
+        }
+        iChangedFlags[index] = 0;
+    }
+    iChangedCells.clear();
+    return(true);
+}
+
+bool Map::Merge(const Map &aOther)
+{
+    if(aOther.iHeight != iHeight || aOther.iWidth != iWidth || aOther.iGrid != iGrid)
+    {
+        std::cerr << "[ERROR] Cannot merge map " << aOther.iHeight << "x" << aOther.iWidth << " with grid " << aOther.iGrid
+                  << " into map " << iHeight << "x" << iWidth << " with grid " << iGrid << "!" << std::endl;
+        return(false);
+    }
+
+    for(unsigned int i = 0; i < iDirectionCount; ++i)
+    {
+        for(unsigned int j = 0; j < iHeight; ++j)
+        {
+            for(unsigned int k = 0; k < iWidth; ++k)
+            {
+                //Unvisited tiles of sparse map are not allocated by reading
+                const MapCell other = aOther.ReadCell(i, j, k);
+                if(other.Counter == 0)
+                    continue;
+
+                MapCell cell = ReadCell(i, j, k);
+                const double count = double(cell.Counter) + other.Counter;
+                const double A = cell.Counter/count;
+                const double B = other.Counter/count;
+                cell.Velocity = A*cell.Velocity + B*other.Velocity;
+                cell.mean_square_x = A*cell.mean_square_x + B*other.mean_square_x;
+                cell.mean_square_y = A*cell.mean_square_y + B*other.mean_square_y;
+                cell.Counter += other.Counter;
+                WriteCell(i, j, k, cell);
+            }
+        }
+    }
+    return(true);
 }
 
 std::complex<double> Map::GetVelocitVector(unsigned int aXPosition, unsigned int aYPosition, double aDirection) const
 {
     unsigned int x= (unsigned int)(floor(double(aXPosition)/iGrid ));
     unsigned int y= (unsigned int)(floor(double(aYPosition)/iGrid ));
+    if(x >= iWidth || y >= iHeight)
+        return std::complex<double>(0, 0);
     int direction = CalcDirection(aDirection);
-    return iVelocityMatrix[direction][y][x].Velocity;
+    return ReadVelocity(direction, y, x);
 }
 
 void Map::PlotMap()
 {
-    static bool first_loop = true;
-
-    if(first_loop)
+    if(!iPlotWindowOpened)
         cv::namedWindow("Map", cv::WINDOW_AUTOSIZE);
 
-    first_loop = false;
+    iPlotWindowOpened = true;
     cv::Mat plot(iHeight*iGrid, iWidth*iGrid, CV_8UC3, cv::Scalar(255,255,255));
 
     cv::Point_<double> first, second;
@@ -148,10 +531,11 @@ void Map::PlotMap()
         {
             first.x = j*iGrid;
             first.y = i*iGrid;
-            for(unsigned short k=0; k<4; ++k)
+            for(unsigned short k=0; k<iDirectionCount; ++k)
             {
-                second.x = j*iGrid + iVelocityMatrix[k][i][j].Velocity.real();
-                second.y = i*iGrid + iVelocityMatrix[k][i][j].Velocity.imag();
+                const std::complex<double> velocity = ReadVelocity(k, i, j);
+                second.x = j*iGrid + velocity.real();
+                second.y = i*iGrid + velocity.imag();
                 cv::line(plot, first, second, colors[k], 1);
             }
         }
@@ -163,13 +547,13 @@ void Map::PlotMap()
 
 std::ostream &operator<<(std::ostream &aStream, const Map &aMap)
 {
-    for (unsigned int i = 0; i < 4; ++i)
+    for (unsigned int i = 0; i < Map::iDirectionCount; ++i)
     {
         for(unsigned int j=0; j<aMap.iHeight; ++j)
         {
             for(unsigned int k=0; k<aMap.iWidth; ++k)
             {
-                aStream << aMap.iVelocityMatrix[i][j][k].Velocity << ", ";
+                aStream << aMap.ReadVelocity(i, j, k) << ", ";
             }
             aStream << std::endl;
         }
@@ -178,19 +562,68 @@ std::ostream &operator<<(std::ostream &aStream, const Map &aMap)
     return aStream;
 }
 
-void Map::SaveMap()
+bool Map::SaveMap()
+{
+    /*
+     * Map is written to a temporary file which replaces the old one, so the old map stays valid if writing
+     * fails and the file mapped by Map#LoadMap is not truncated while the map is saved to the same file.
+     */
+    const std::string temp_file_name = iFileName + ".tmp";
+    bool saved = (iFileFormat == E_binary_map_file) ? SaveBinaryMap(temp_file_name) : SaveTextMap(temp_file_name);
+
+    if(saved && std::rename(temp_file_name.c_str(), iFileName.c_str()) != 0)
+        saved = false;
+    if(!saved)
+    {
+        std::remove(temp_file_name.c_str());
+        std::cerr << "[ERROR] Cannot write map to file " << iFileName << "!" << std::endl;
+    }
+    return(saved);
+}
+
+bool Map::LoadMap()
+{
+    char magic[sizeof(MAP_FILE_MAGIC)] = {0};
+    std::ifstream input_file(iFileName, std::ios::in | std::ios::binary);
+    if(!input_file.good())
+    {
+        std::cerr << "[ERROR] Cannot open file with map! New map will be created." << std::endl;
+        return(false);
+    }
+    input_file.read(magic, sizeof(magic));
+    input_file.close();
+
+    if(std::memcmp(magic, MAP_FILE_MAGIC, sizeof(magic)) == 0)
+        return LoadBinaryMap();
+    return LoadTextMap();
+}
+
+bool Map::LoadMap(const std::string &aFallbackFileName)
+{
+    if(std::ifstream(iFileName).good() || !std::ifstream(aFallbackFileName).good())
+        return LoadMap();
+
+    std::cout << "Map file " << iFileName << " does not exist, map is loaded from " << aFallbackFileName << std::endl;
+    const std::string file_name = iFileName;
+    iFileName = aFallbackFileName;
+    const bool loaded = LoadMap();
+    iFileName = file_name;
+    return(loaded);
+}
+
+bool Map::SaveTextMap(const std::string &aFileName) const
 {
-    std::ofstream output_file(iFileName, std::ios::out);
+    std::ofstream output_file(aFileName, std::ios::out);
     if(output_file.is_open())
     {
         output_file << iHeight << ";" << iWidth << ";" << iGrid << ";" << std::endl;
-        for (unsigned int i = 0; i < 4; ++i)
+        for (unsigned int i = 0; i < iDirectionCount; ++i)
         {
             for(unsigned int j=0; j<iHeight; ++j)
             {
                 for(unsigned int k=0; k<iWidth; ++k)
                 {
-                    output_file << iVelocityMatrix[i][j][k].Velocity << ";";
+                    output_file << ReadVelocity(i, j, k) << ";";
                 }
                 output_file << std::endl;
             }
@@ -198,10 +631,10 @@ void Map::SaveMap()
         }
         output_file.close();
     }
-
+    return(!output_file.fail());
 }
 
-void Map::LoadMap()
+bool Map::LoadTextMap()
 {
     std::ifstream input_file(iFileName, std::ios::in);
     std::string temp_str;
@@ -217,7 +650,7 @@ void Map::LoadMap()
         getline(input_file, temp_str, ';');
         iGrid = (unsigned int)std::stoul(temp_str);
         AllocateVelocityMatrix();
-        for (unsigned int i = 0; i < 4; ++i)
+        for (unsigned int i = 0; i < iDirectionCount; ++i)
         {
             for(unsigned int j=0; j<iHeight; ++j)
             {
@@ -225,20 +658,187 @@ void Map::LoadMap()
                 {
                     getline(input_file, temp_str, ';');
                     is.str(temp_str);
-                    is >> iVelocityMatrix[i][j][k].Velocity;
-                    iVelocityMatrix[i][j][k].Counter++;
+                    MapCell cell = ReadCell(i, j, k);
+                    is >> cell.Velocity;
+                    //Empty cells must not allocate tiles of sparse map, they stay unobserved (see Map)
+                    if(iTileSize != 0 && cell.Velocity == std::complex<double>(0, 0))
+                        continue;
+                    cell.Counter++;
+                    WriteCell(i, j, k, cell);
                 }
             }
         }
         input_file.close();
+        return(true);
     }else{
         std::cerr << "[ERROR] Cannot open file with map! New map will be created." << std::endl;
+        return(false);
+    }
+}
+
+bool Map::SaveBinaryMap(const std::string &aFileName) const
+{
+    //Only populated tiles are stored
+    std::vector<uint32_t> tile_table;
+    for(size_t i = 0; i < iTiles.size(); ++i)
+    {
+        if(iTiles[i] != nullptr)
+            tile_table.push_back(uint32_t(i));
+    }
+    const uint64_t table_size = TileTableBytes(tile_table.size());
+    tile_table.resize(table_size/sizeof(uint32_t), 0);
+
+    MapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.Magic, MAP_FILE_MAGIC, sizeof(header.Magic));
+    header.Version = MAP_FILE_VERSION;
+    header.Height = iHeight;
+    header.Width = iWidth;
+    header.Grid = iGrid;
+    header.Directions = iDirectionCount;
+    header.Layout = iLayout;
+    header.CellSize = uint32_t(iCellSize);
+    header.Encoding = iEncoding;
+    header.TileSize = iTileSize;
+    header.TileCount = uint32_t(GetPopulatedTiles());
+    header.DataSize = table_size + uint64_t(header.TileCount)*TileBytes();
+    header.Checksum = CalcChecksum(tile_table.data(), table_size);
+    for(const unsigned char *tile : iTiles)
+    {
+        if(tile != nullptr)
+            header.Checksum = CalcChecksum(tile, TileBytes(), header.Checksum);
+    }
+
+    std::ofstream output_file(aFileName, std::ios::out | std::ios::binary | std::ios::trunc);
+    if(output_file.is_open())
+    {
+        output_file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        output_file.write(reinterpret_cast<const char *>(tile_table.data()), table_size);
+        for(const unsigned char *tile : iTiles)
+        {
+            if(tile != nullptr)
+                output_file.write(reinterpret_cast<const char *>(tile), TileBytes());
+        }
+        output_file.close();
     }
+    return(!output_file.fail());
+}
+
+bool Map::LoadBinaryMap()
+{
+    int file = open(iFileName.c_str(), O_RDONLY);
+    if(file < 0)
+    {
+        std::cerr << "[ERROR] Cannot open file with map! New map will be created." << std::endl;
+        return(false);
+    }
+
+    struct stat file_info;
+    if(fstat(file, &file_info) != 0 || size_t(file_info.st_size) < sizeof(MapFileHeader))
+    {
+        close(file);
+        std::cerr << "[ERROR] Map file " << iFileName << " is too short! New map will be created." << std::endl;
+        return(false);
+    }
+
+    //Private mapping: pages are shared with other processes until the map is modified
+    const size_t file_size = size_t(file_info.st_size);
+    void *mapping = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+    close(file);
+    if(mapping == MAP_FAILED)
+    {
+        std::cerr << "[ERROR] Cannot map file " << iFileName << " to memory! New map will be created." << std::endl;
+        return(false);
+    }
+
+    const MapFileHeader &header = *static_cast<const MapFileHeader *>(mapping);
+    const char *data = static_cast<const char *>(mapping) + sizeof(MapFileHeader);
+
+    //Version 1 contains only dense matrix without tile table
+    const bool dense_version = (header.Version == MAP_FILE_DENSE_VERSION);
+    const uint64_t tile_size = dense_version ? 0 : header.TileSize;
+    const uint64_t tile_count = dense_version ? 1 : header.TileCount;
+    const uint64_t table_size = dense_version ? 0 : TileTableBytes(tile_count);
+    const uint32_t *tile_table = reinterpret_cast<const uint32_t *>(data);
+    uint64_t total_tiles = 1;
+    uint64_t tile_cells = uint64_t(header.Height)*header.Width;
+    if(tile_size != 0)
+    {
+        total_tiles = ((header.Height + tile_size - 1)/tile_size)*((header.Width + tile_size - 1)/tile_size);
+        tile_cells = tile_size*tile_size;
+    }
+    //Header is not covered by the checksum, size of a tile which does not fit into 64 bits is left zero
+    const uint64_t cell_bytes = uint64_t(header.Directions)*header.CellSize;
+    const uint64_t tile_bytes = (cell_bytes != 0 && tile_cells <= UINT64_MAX/cell_bytes) ? tile_cells*cell_bytes : 0;
+    const uint64_t data_limit = file_size - sizeof(MapFileHeader);
+
+    const char *error = nullptr;
+    if(header.Version != MAP_FILE_VERSION && !dense_version)
+        error = "unsupported version";
+    else if(header.Grid == 0 || header.Height == 0 || header.Width == 0)
+        error = "wrong header";
+    else if(header.Directions != iDirectionCount || header.Layout > E_cell_major || header.Encoding > E_fixed16_cell ||
+            header.CellSize != CellSize(MapCellEncoding(header.Encoding)))
+        error = "incompatible cell format";
+    else if((tile_size & (tile_size - 1)) != 0 || tile_count > total_tiles || (tile_size == 0 && tile_count != 1) ||
+            header.Height + tile_size - 1 > UINT32_MAX || header.Width + tile_size - 1 > UINT32_MAX)
+        error = "wrong tiles";
+    else if(tile_bytes == 0 || table_size > data_limit || tile_count > (data_limit - table_size)/tile_bytes ||
+            header.DataSize != table_size + tile_count*tile_bytes)
+        error = "wrong size of data";
+    else if(header.Checksum != CalcChecksum(data, header.DataSize))
+        error = "wrong checksum";
+
+    //Indices of tiles must be sorted, so every tile is stored only once
+    for(uint64_t i = 0; error == nullptr && !dense_version && i < tile_count; ++i)
+    {
+        if(tile_table[i] >= total_tiles || (i > 0 && tile_table[i] <= tile_table[i - 1]))
+            error = "wrong tile table";
+    }
+
+    if(error != nullptr)
+    {
+        munmap(mapping, file_size);
+        std::cerr << "[ERROR] Map file " << iFileName << ": " << error << "! New map will be created." << std::endl;
+        return(false);
+    }
+
+    DeleteVelocityMatrix();
+    iHeight = header.Height;
+    iWidth = header.Width;
+    iGrid = header.Grid;
+    iLayout = MapLayout(header.Layout);
+    iEncoding = MapCellEncoding(header.Encoding);
+    iCellSize = header.CellSize;
+    iTileSize = (unsigned int)tile_size;
+    iMappedFile = mapping;
+    iMappedSize = file_size;
+
+    //Tiles point directly to mapped file
+    SetupTiles();
+    unsigned char *tiles = static_cast<unsigned char *>(mapping) + sizeof(MapFileHeader) + table_size;
+    for(uint64_t i = 0; i < tile_count; ++i)
+        iTiles[dense_version ? 0 : tile_table[i]] = tiles + i*tile_bytes;
+
+    return(true);
 }
 
 void Map::SetFileName(std::string aFileName)
 {
     iFileName = aFileName;
+
+    //Old text format is used for files with suffix .txt
+    const std::string text_suffix = ".txt";
+    if(aFileName.size() >= text_suffix.size() &&
+            aFileName.compare(aFileName.size() - text_suffix.size(), text_suffix.size(), text_suffix) == 0)
+        iFileFormat = E_text_map_file;
+    else
+        iFileFormat = E_binary_map_file;
+}
+
+void Map::SetFileFormat(MapFileFormat aFormat)
+{
+    iFileFormat = aFormat;
 }
 
 double Map::CalcAngle(double const aDeltaY, double const aDeltaX)
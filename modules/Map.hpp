@@ -9,64 +9,285 @@
 
 #include <iostream>
 #include <complex>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \struct MapCell
+ * \brief Cell contains velocity vector and counter
+ *
+ * Velocity vector is implemented as complex number.
+ * Counter is used for averaging vector value.
+ *
+ */
+struct MapCell
+{
+    std::complex<double> Velocity;
+    unsigned int Counter;
+    double mean_square_x, mean_square_y;
+    double VarianceX() { return mean_square_x - Velocity.real(); }
+    double VarianceY() { return mean_square_y - Velocity.imag(); }
+};
+
+/*!
+ * \struct MapCellFloat
+ * \brief Map cell encoded with single precision numbers (24 bytes instead of 40 bytes of MapCell)
+ */
+struct MapCellFloat
+{
+    std::complex<float> Velocity;
+    float mean_square_x, mean_square_y;
+    uint32_t Counter;
+    uint32_t Padding;
+};
+
+/*!
+ * \struct MapCellFixed16
+ * \brief Map cell encoded with fixed point numbers (16 bytes, four directions of a cell fill one cache line in
+ * layout E_cell_major)
+ *
+ * Velocity is stored in 16-bit Q8.8 format (range +-128 px per frame, step 1/256 px), mean squares in
+ * unsigned 32-bit Q16.16 format and the counter saturates at 65535.
+ */
+struct MapCellFixed16
+{
+    int16_t VelocityX, VelocityY;
+    uint16_t Counter;
+    uint16_t Padding;
+    uint32_t MeanSquareX, MeanSquareY;
+};
+
+/*!
+ * \brief Encoding of map cells in memory
+ *
+ * IIR filter in Map#SetVelocityVector is always computed in double precision, only the stored result is
+ * rounded. Error of velocity measured by MapEncoding test (1e6 random vectors with deviation 8 px) is
+ * below 1e-5 px for E_float_cell and below 0.03 px (mean 0.003 px) for E_fixed16_cell. Rounding errors of
+ * E_fixed16_cell cannot accumulate above step/(2*0.02) = 0.1 px, because the filter forgets old values
+ * with coefficient 0.02.
+ */
+enum MapCellEncoding
+{
+    E_double_cell=0,    ///< MapCell, 40 bytes
+    E_float_cell=1,     ///< MapCellFloat, 24 bytes
+    E_fixed16_cell=2    ///< MapCellFixed16, 16 bytes
+};
+
+//! Order of map cells in memory
+enum MapLayout
+{
+    E_direction_major=0,    ///< Matrices of all directions are stored one after another
+    E_cell_major=1          ///< All directions of one cell are stored next to each other
+};
+
+//! Format of file with map
+enum MapFileFormat
+{
+    E_text_map_file=0,      ///< Semicolon separated text file with velocity vectors
+    E_binary_map_file=1     ///< Binary file with header and cells which can be mapped to memory
+};
 
 /*!
  * \class Map
  * \brief Implements map of movement in video
  *
- * Map is implemented as 3D array of map cells.
+ * Map is implemented as 3D array of map cells (direction, row, column). Order of cells in memory is given
+ * by MapLayout, their size by MapCellEncoding.
+ *
+ * Dense map stores all cells in a single contiguous memory block aligned to cache line. Sparse map splits
+ * the area into square tiles which are allocated on first write, so only regions where some movement was
+ * observed take memory. Cells of tiles which were never written have zero velocity.
+ *
+ * Text file contains only velocities, every loaded cell is counted as one observation. Sparse map skips cells
+ * with zero velocity, so they stay unobserved: the first new vector replaces such a cell instead of being
+ * averaged with zero and Map#Merge skips it. Sparse map learned further after loading a text file therefore
+ * differs from dense one in cells which had zero velocity.
+ *
+ * Map can be saved to a text file or to a binary file (see MapFileFormat). Binary file is mapped to memory
+ * when it is loaded, so no parsing is done and more processes can share the same pages of file. Only
+ * populated tiles of sparse map are stored in binary file.
  *
  */
 class Map
 {
 private:
-    struct MapCell ***iVelocityMatrix;
+    static const unsigned int iDirectionCount = 4;
+
+    std::vector<unsigned char *> iTiles;    ///< Tiles of velocity matrix, dense map has only one tile
+    void *iMappedFile;
+    size_t iMappedSize;
+    MapLayout iLayout;
+    MapCellEncoding iEncoding;
+    size_t iCellSize;
+    MapFileFormat iFileFormat;
+    unsigned int iTileSize;                 ///< Side of tile in cells (power of two), 0 for dense map
+    unsigned int iTileShift;
+    unsigned int iTileHeight, iTileWidth;   ///< Size of one tile in cells
+    unsigned int iTileRows, iTileColumns;   ///< Number of tiles
     unsigned int iGrid, iHeight, iWidth;
     std::string iFileName;
+    bool iTrackChanges;
+    bool iPlotWindowOpened;
+    std::vector<uint8_t> iChangedFlags;     ///< Flag for every position (all directions) changed since the last copy
+    std::vector<uint32_t> iChangedCells;    ///< Positions (row*width + column) with flag set
+    std::vector<uint32_t> iBatchColumns, iBatchRows, iBatchDirections;  ///< Scratch buffers of Map#SetVelocityVectors
+    std::vector<std::complex<double>> iBatchVelocity;
     static int CalcDirection(double aAngle);
+    //! Apply IIR filter of velocity and mean squares to cell
+    static void FilterCell(MapCell &aCell, const std::complex<double> &aVelocity);
 
+    //! Calculate geometry of tiles and create empty table of tiles
+    void SetupTiles();
     void AllocateVelocityMatrix();
     void DeleteVelocityMatrix();
+    unsigned char *AllocateTile() const;
+    bool IsMappedTile(const unsigned char *aTile) const;
+
+    bool SaveTextMap(const std::string &aFileName) const;
+    bool LoadTextMap();
+    bool SaveBinaryMap(const std::string &aFileName) const;
+    bool LoadBinaryMap();
+
+    //! Size of one tile in bytes
+    size_t TileBytes() const { return size_t(iDirectionCount)*iTileHeight*iTileWidth*iCellSize; }
+
+    //! Return index of tile containing given cell
+    size_t TileIndex(unsigned int aRow, unsigned int aColumn) const
+    {
+        if(iTileSize == 0)
+            return 0;
+        return size_t(aRow >> iTileShift)*iTileColumns + (aColumn >> iTileShift);
+    }
+
+    //! Return offset of cell in its tile in bytes
+    size_t CellOffset(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const
+    {
+        if(iTileSize != 0)
+        {
+            aRow &= iTileSize - 1;
+            aColumn &= iTileSize - 1;
+        }
+        if(iLayout == E_cell_major)
+            return ((size_t(aRow)*iTileWidth + aColumn)*iDirectionCount + aDirection)*iCellSize;
+        return ((size_t(aDirection)*iTileHeight + aRow)*iTileWidth + aColumn)*iCellSize;
+    }
+
+    //! Return cell data or null pointer if its tile was not allocated
+    const unsigned char *FindCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const
+    {
+        const unsigned char *tile = iTiles[TileIndex(aRow, aColumn)];
+        return (tile != nullptr) ? tile + CellOffset(aDirection, aRow, aColumn) : nullptr;
+    }
+
+    //! Return cell data, tile is allocated if needed
+    unsigned char *GetCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn)
+    {
+        unsigned char *&tile = iTiles[TileIndex(aRow, aColumn)];
+        if(tile == nullptr)
+            tile = AllocateTile();
+        return tile + CellOffset(aDirection, aRow, aColumn);
+    }
+
+    //! Remember position of changed cells for Map#CopyChangedCells
+    void MarkChanged(unsigned int aRow, unsigned int aColumn)
+    {
+        const uint32_t index = aRow*iWidth + aColumn;
+        if(iChangedFlags[index] == 0)
+        {
+            iChangedFlags[index] = 1;
+            iChangedCells.push_back(index);
+        }
+    }
+
+    //! Decode cell at given position
+    MapCell ReadCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const;
+    //! Encode cell at given position
+    void WriteCell(unsigned int aDirection, unsigned int aRow, unsigned int aColumn, const MapCell &aCell);
+    //! Decode only velocity of cell at given position
+    std::complex<double> ReadVelocity(unsigned int aDirection, unsigned int aRow, unsigned int aColumn) const;
 
 public:
-    //! Constructor takes video size and grid of velocity matrix
-    Map(unsigned int aHeight, unsigned int aWidth, unsigned int aGrid);
+    /*!
+     * \brief Constructor takes video size, grid of velocity matrix, memory layout and encoding of cells
+     *
+     * Map is sparse if aTileSize is not zero, the size is rounded up to power of two.
+     */
+    Map(unsigned int aHeight, unsigned int aWidth, unsigned int aGrid, MapLayout aLayout = E_direction_major,
+            MapCellEncoding aEncoding = E_double_cell, unsigned int aTileSize = 0);
     //! Destructor
     ~Map();
+    Map(const Map &) = delete;
+    Map &operator=(const Map &) = delete;
     //! Add new velocity vector
     void SetVelocityVector(unsigned int aXPosition, unsigned int aYPosition, double aXVelocity, double aYVelocity, double aDirection);
+    /*!
+     * \brief Add velocity vectors of all features tracked by optical flow
+     *
+     * Result is the same as calling Map#SetVelocityVector for every feature with aStatus set, in order of
+     * features. Cells and directions of all features are computed at once in a loop without branches, then
+     * the filter is applied to the cells.
+     */
+    void SetVelocityVectors(const std::vector<cv::Point2f> &aFrom, const std::vector<cv::Point2f> &aTo,
+            const std::vector<uchar> &aStatus);
+    /*!
+     * \brief Add cells of map learned from another video of the same scene
+     *
+     * Velocity and mean squares of every cell are averaged with weights given by counters of cells. Maps must
+     * have the same size and grid, otherwise false is returned and the map is not changed.
+     */
+    bool Merge(const Map &aOther);
     //! Get velocity vector
     std::complex<double> GetVelocitVector(unsigned int aXPosition, unsigned int aYPosition, double aDirection) const;
+    //! Turn on or off tracking of cells changed since the last Map#CopyChangedCells (off by default)
+    void SetChangeTracking(bool aEnabled);
+    //! Return number of positions changed since the last Map#CopyChangedCells
+    size_t GetChangedCount() const { return iChangedCells.size(); }
+    //! Forget all tracked changes
+    void ClearChanges();
+    //! Create deep copy of map including name and format of file, changes are not tracked in the copy
+    std::unique_ptr<Map> Clone() const;
+    /*!
+     * \brief Copy cells changed since the last call to a map created by Map#Clone and forget the changes
+     *
+     * Only the changed cells are copied, so the target can be updated while the map is being learned.
+     * False is returned if size or format of the target differs (for example when another map was loaded).
+     */
+    bool CopyChangedCells(Map &aTarget);
     //! Display window with map
     void PlotMap();
     //! Debug output
     friend std::ostream& operator<< (std::ostream& aStream, const Map &aMap);
-    //! Save map to file
-    void SaveMap();
-    //! Load map from file
-    void LoadMap();
-    //! Set name of file containing map
+    //! Save map to file, old file is replaced only when the whole map was written
+    bool SaveMap();
+    //! Load map from file, format of file is detected automatically
+    bool LoadMap();
+    /*!
+     * \brief Load map from aFallbackFileName if the map file does not exist
+     *
+     * Used to load maps in the old text format, the map is still saved to the file set by Map#SetFileName.
+     */
+    bool LoadMap(const std::string &aFallbackFileName);
+    //! Set name of file containing map, text format is used for suffix .txt, binary format otherwise
     void SetFileName(std::string aFileName);
+    //! Set format used by Map#SaveMap
+    void SetFileFormat(MapFileFormat aFormat);
     //! Calculate angle which object is coming from
     static double CalcAngle(double const aDeltaY, double const aDeltaX);
+    //! Return size of one cell in bytes for given encoding
+    static size_t CellSize(MapCellEncoding aEncoding);
+    //! Return encoding of cells
+    MapCellEncoding GetEncoding() const { return iEncoding; }
+    //! Return side of tile in cells, 0 for dense map
+    unsigned int GetTileSize() const { return iTileSize; }
+    //! Return number of allocated tiles
+    size_t GetPopulatedTiles() const;
+    //! Return memory taken by cells in bytes
+    size_t GetMemoryUsage() const { return GetPopulatedTiles()*TileBytes(); }
 
 };
 
-/*!
- * \struct MapCell
- * \brief Cell contains velocity vector and counter
- *
- * Velocity vector is implemented as complex number.
- * Counter is used for averaging vector value.
- *
- */
-struct MapCell
-{
-    std::complex<double> Velocity;
-    unsigned int Counter;
-    double mean_square_x, mean_square_y;
-    double VarianceX() { return mean_square_x - Velocity.real(); }
-    double VarianceY() { return mean_square_y - Velocity.imag(); }
-};
-
 #endif //__MAP_HPP__
\ No newline at end of file
@@ -8,7 +8,9 @@
 
 void MapBasedTracker::Predict(double aAngle)
 {
-    std::complex<double> velocity_vector = TrackerBase::iMap->GetVelocitVector
+    if(iMap == nullptr)
+        return;
+    std::complex<double> velocity_vector = iMap->GetVelocitVector
             ((unsigned int)iPosition.x, (unsigned int)iPosition.y, aAngle);
     iPredictedPosition.x += int(velocity_vector.real());
     iPredictedPosition.y += int(velocity_vector.imag());
@@ -16,16 +16,20 @@
  * \brief Implements tracker as a child of Tracker base
  *
  *  Core of this tracker is map. Map is used to predict next position of an object.
- *  Unlike Kalman filter, this tracker has no model of objects movement.
+ *  Unlike Kalman filter, this tracker has no model of objects movement. Tracker without map
+ *  predicts no movement.
  *
  */
 class MapBasedTracker : public TrackerBase
 {
 private:
+    const Map *iMap;
     cv::Point iPosition, iPredictedPosition;
 public:
 
-    MapBasedTracker()
+    //! Constructor, map must exist as long as the tracker
+    explicit MapBasedTracker(const Map *aMap = nullptr) :
+            iMap(aMap)
     {}
 
     ~MapBasedTracker()
@@ -0,0 +1,80 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include "MapCheckpointer.hpp"
+
+MapCheckpointer::MapCheckpointer(std::shared_ptr<Map> aMap, double aInterval, size_t aChangeLimit) :
+        iMap(aMap),
+        iInterval(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(aInterval))),
+        iChangeLimit(aChangeLimit),
+        iLastCheckpoint(std::chrono::steady_clock::now()),
+        iCheckpointCount(0),
+        iSnapshotReady(false),
+        iStop(false)
+{
+    iMap->SetChangeTracking(true);
+    iWriter = std::thread(&MapCheckpointer::RunWriter, this);
+}
+
+MapCheckpointer::~MapCheckpointer()
+{
+    {
+        std::lock_guard<std::mutex> lock(iMutex);
+        iStop = true;
+    }
+    iCondition.notify_all();
+    iWriter.join();
+    iMap->SetChangeTracking(false);
+}
+
+void MapCheckpointer::Poll()
+{
+    const bool interval_elapsed = iInterval.count() > 0 && std::chrono::steady_clock::now() - iLastCheckpoint >= iInterval;
+    const bool limit_reached = iChangeLimit > 0 && iMap->GetChangedCount() >= iChangeLimit;
+    if(!interval_elapsed && !limit_reached)
+        return;
+
+    {
+        //Shadow map belongs to the writer until the previous snapshot is written
+        std::lock_guard<std::mutex> lock(iMutex);
+        if(iSnapshotReady)
+            return;
+
+        if(iShadowMap == nullptr || !iMap->CopyChangedCells(*iShadowMap))
+        {
+            iShadowMap = iMap->Clone();
+            iMap->ClearChanges();
+        }
+        iSnapshotReady = true;
+        iLastCheckpoint = std::chrono::steady_clock::now();
+    }
+    iCondition.notify_one();
+}
+
+void MapCheckpointer::RunWriter()
+{
+    std::unique_lock<std::mutex> lock(iMutex);
+    while(true)
+    {
+        iCondition.wait(lock, [this](){ return iSnapshotReady || iStop; });
+        if(!iSnapshotReady)
+            break;
+
+        //Map is written without lock, Poll does not touch the shadow map until iSnapshotReady is cleared
+        lock.unlock();
+        const bool saved = iShadowMap->SaveMap();
+        lock.lock();
+
+        if(saved)
+            ++iCheckpointCount;
+        iSnapshotReady = false;
+    }
+}
+
+unsigned long MapCheckpointer::GetCheckpointCount()
+{
+    std::lock_guard<std::mutex> lock(iMutex);
+    return iCheckpointCount;
+}
@@ -0,0 +1,72 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class MapCheckpointer
+ *
+ */
+
+#ifndef __MAPCHECKPOINTER_HPP__
+#define __MAPCHECKPOINTER_HPP__
+
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include "Map.hpp"
+
+/*!
+ * \class MapCheckpointer
+ * \brief Saves velocity map periodically in a background thread
+ *
+ * Map is saved to its file (see Map#SaveMap) when the interval elapsed or when enough positions of the map
+ * were changed since the last checkpoint. Snapshot of the map is a shadow copy which is updated only by the
+ * changed cells (see Map#CopyChangedCells), so taking it is cheap. The shadow copy is written by the
+ * background thread while the map is being updated, the old file is replaced only by a complete new file.
+ *
+ * MapCheckpointer#Poll must be called by the thread which updates the map, right after the update. If the
+ * previous checkpoint is still being written, the new one is postponed, so the calling thread never waits
+ * for disk.
+ */
+class MapCheckpointer
+{
+private:
+    std::shared_ptr<Map> iMap;
+    std::unique_ptr<Map> iShadowMap;
+    std::chrono::steady_clock::duration iInterval;
+    size_t iChangeLimit;
+    std::chrono::steady_clock::time_point iLastCheckpoint;
+    unsigned long iCheckpointCount;
+
+    std::thread iWriter;
+    std::mutex iMutex;
+    std::condition_variable iCondition;
+    bool iSnapshotReady, iStop;
+
+    void RunWriter();
+
+public:
+    /*!
+     * \brief Constructor turns on tracking of changes in aMap and starts the background thread
+     *
+     * Checkpoint is made every aInterval seconds or after aChangeLimit changed positions, zero turns off
+     * the condition.
+     */
+    MapCheckpointer(std::shared_ptr<Map> aMap, double aInterval, size_t aChangeLimit);
+
+    //! Destructor waits until the last checkpoint is written
+    ~MapCheckpointer();
+
+    MapCheckpointer(const MapCheckpointer &) = delete;
+    MapCheckpointer &operator=(const MapCheckpointer &) = delete;
+
+    //! Take snapshot of the map if a checkpoint is due and the previous one is written
+    void Poll();
+
+    //! Return number of written checkpoints
+    unsigned long GetCheckpointCount();
+};
+
+#endif //__MAPCHECKPOINTER_HPP__
@@ -0,0 +1,131 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <iostream>
+#include <thread>
+#include <algorithm>
+
+#include "MapLearner.hpp"
+#include "VideoProcessor.hpp"
+
+MapLearner::MapLearner(unsigned int aThreadCount) :
+        iThreadCount(aThreadCount),
+        iEncoding(E_double_cell),
+        iTileSize(0),
+        iNextRecording(0),
+        iNextMerge(0)
+{
+    if(iThreadCount == 0)
+        iThreadCount = std::max(1u, std::thread::hardware_concurrency());
+}
+
+void MapLearner::AddRecording(const std::string &aVideoFile, const std::string &aBgImageFile)
+{
+    Recording recording;
+    recording.VideoFile = aVideoFile;
+    recording.BgImageFile = aBgImageFile;
+    recording.Done = false;
+    iRecordings.push_back(std::move(recording));
+}
+
+void MapLearner::SetMapStorage(MapCellEncoding aEncoding, unsigned int aTileSize)
+{
+    iEncoding = aEncoding;
+    iTileSize = aTileSize;
+}
+
+std::shared_ptr<Map> MapLearner::LearnRecording(const Recording &aRecording)
+{
+    VideoProcessor video_processor(false);
+    video_processor.SetMapEncoding(iEncoding);
+    video_processor.SetMapTileSize(iTileSize);
+    //Recording is processed by a worker thread, nested parallel pre-processing would oversubscribe the cores
+    video_processor.SetParallelPreProcessing(false);
+    if(!video_processor.OpenFile(aRecording.VideoFile))
+    {
+        std::cerr << "[ERROR] Recording " << aRecording.VideoFile << " is skipped!" << std::endl;
+        return nullptr;
+    }
+    if(!aRecording.BgImageFile.empty() && !video_processor.OpenBackgroundImage(aRecording.BgImageFile))
+        std::cerr << "[ERROR] Cannot open bg image " << aRecording.BgImageFile << "!" << std::endl;
+
+    unsigned long frames = 0;
+    while(video_processor.ReadNextFrame())
+        ++frames;
+
+    std::cout << "Recording " << aRecording.VideoFile << ": " << frames << " frames" << std::endl;
+    return video_processor.GetMap();
+}
+
+void MapLearner::MergeRecording(size_t aIndex, std::shared_ptr<Map> aMap)
+{
+    std::lock_guard<std::mutex> lock(iMergeMutex);
+    iRecordings[aIndex].LearnedMap = aMap;
+    iRecordings[aIndex].Done = true;
+
+    //Maps are merged in order of recordings, later recordings wait in their slots
+    while(iNextMerge < iRecordings.size() && iRecordings[iNextMerge].Done)
+    {
+        std::shared_ptr<Map> &learned_map = iRecordings[iNextMerge].LearnedMap;
+        if(learned_map != nullptr)
+        {
+            if(iResult == nullptr)
+                iResult = learned_map;
+            else if(!iResult->Merge(*learned_map))
+                std::cerr << "[ERROR] Map of recording " << iRecordings[iNextMerge].VideoFile << " is skipped!" << std::endl;
+        }
+        learned_map = nullptr;
+        ++iNextMerge;
+    }
+}
+
+void MapLearner::RunWorker()
+{
+    try
+    {
+        while(true)
+        {
+            size_t index;
+            {
+                std::lock_guard<std::mutex> lock(iMergeMutex);
+                if(iNextRecording >= iRecordings.size() || iError)
+                    break;
+                index = iNextRecording++;
+            }
+            MergeRecording(index, LearnRecording(iRecordings[index]));
+        }
+    }catch(...){
+        std::lock_guard<std::mutex> lock(iMergeMutex);
+        if(!iError)
+            iError = std::current_exception();
+    }
+}
+
+std::shared_ptr<Map> MapLearner::Learn(std::shared_ptr<Map> aMap)
+{
+    iResult = aMap;
+    iNextRecording = 0;
+    iNextMerge = 0;
+    iError = nullptr;
+    for(Recording &recording : iRecordings)
+    {
+        recording.LearnedMap = nullptr;
+        recording.Done = false;
+    }
+
+    std::vector<std::thread> workers;
+    const size_t thread_count = std::min<size_t>(iThreadCount, iRecordings.size());
+    for(size_t i = 0; i < thread_count; ++i)
+        workers.emplace_back(&MapLearner::RunWorker, this);
+    for(std::thread &worker : workers)
+        worker.join();
+
+    if(iError)
+        std::rethrow_exception(iError);
+
+    std::shared_ptr<Map> result = iResult;
+    iResult = nullptr;
+    return result;
+}
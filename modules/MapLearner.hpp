@@ -0,0 +1,72 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class MapLearner
+ *
+ */
+
+#ifndef __MAPLEARNER_HPP__
+#define __MAPLEARNER_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <exception>
+
+#include "Map.hpp"
+
+/*!
+ * \class MapLearner
+ * \brief Learns velocity map from many recordings of the same camera in parallel
+ *
+ * Every recording is processed by its own VideoProcessor in one of the worker threads, so it is learned into
+ * a private map. Private maps are merged (see Map#Merge) into the result strictly in order in which the
+ * recordings were added, as soon as all previous recordings are merged. Result is therefore the same for any
+ * number of threads. Only private maps which wait for a longer earlier recording are kept in memory.
+ */
+class MapLearner
+{
+private:
+    struct Recording
+    {
+        std::string VideoFile, BgImageFile;
+        std::shared_ptr<Map> LearnedMap;
+        bool Done;
+    };
+
+    std::vector<Recording> iRecordings;
+    unsigned int iThreadCount;
+    MapCellEncoding iEncoding;
+    unsigned int iTileSize;
+
+    std::mutex iMergeMutex;
+    size_t iNextRecording, iNextMerge;
+    std::shared_ptr<Map> iResult;
+    std::exception_ptr iError;
+
+    void RunWorker();
+    std::shared_ptr<Map> LearnRecording(const Recording &aRecording);
+    void MergeRecording(size_t aIndex, std::shared_ptr<Map> aMap);
+
+public:
+    //! Constructor, number of threads is taken from the hardware if aThreadCount is 0
+    explicit MapLearner(unsigned int aThreadCount = 0);
+
+    //! Add video file, background image is optional (see VideoProcessor#OpenBackgroundImage)
+    void AddRecording(const std::string &aVideoFile, const std::string &aBgImageFile = "");
+
+    //! Set encoding and tile size of private maps (see Map constructor)
+    void SetMapStorage(MapCellEncoding aEncoding, unsigned int aTileSize);
+
+    /*!
+     * \brief Learn all added recordings
+     *
+     * Maps of the recordings are merged into aMap, which can be an already learned map of the camera. If aMap
+     * is null, map of the first recording is used as the base. Result is null if no recording could be opened.
+     */
+    std::shared_ptr<Map> Learn(std::shared_ptr<Map> aMap = nullptr);
+};
+
+#endif //__MAPLEARNER_HPP__
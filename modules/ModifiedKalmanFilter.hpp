@@ -11,10 +11,10 @@
 #include <memory>
 
 #include <opencv2/core/core.hpp>
-#include <opencv2/video/tracking.hpp>
 
 #include "TrackerBase.hpp"
 #include "Map.hpp"
+#include "FixedKalmanFilter.hpp"
 
 enum KalmanFilterType
 {
@@ -22,6 +22,17 @@ enum KalmanFilterType
     E_constant_acceleration
 };
 
+//! Parameters of model which are shared by ModifiedKalmanFilter and BatchedKalmanFilter
+template<enum KalmanFilterType ModelType>
+struct KalmanModel
+{
+    static constexpr int StateSize = (E_constant_acceleration == ModelType) ? 6 : 4;
+    static constexpr float TimeStep = (E_constant_acceleration == ModelType) ? 10.0f : 3.0f;         // Přenos rychlosti na polohu = čas
+    static constexpr float ProcessNoise = (E_constant_acceleration == ModelType) ? 1e-5f : 1e-4f;   // inicializace Q
+    static constexpr float MeasurementNoise = (E_constant_acceleration == ModelType) ? 5e2f : 1e2f; // inicializace R
+    static constexpr float ErrorCovariance = (E_constant_acceleration == ModelType) ? 1e3f : 1.0f;  // inicializace P
+};
+
 /*!
  * \class ModifiedKalmanFilter
  * \brief Implements tracker with Kalman filter
@@ -29,21 +40,19 @@ enum KalmanFilterType
  * Tracking is based on object model and Kalman filter algorithm. There are two types of
  * model: object with constant velocity and object with constant acceleration.
  *
+ * Type of model is a template parameter, so the filter has fixed size (see FixedKalmanFilter)
+ * and the whole tracker is allocated in one block. Both types are instantiated in ModifiedKalmanFilter.cpp.
+ *
  */
+template<enum KalmanFilterType ModelType>
 class ModifiedKalmanFilter : public TrackerBase
 {
 private:
-    //! Instance of Kalman filter implemented in OpenCV library
-    cv::KalmanFilter iBaseFilter;
-
-    //! Type of model
-    const enum KalmanFilterType iModelType;
+    //! Kalman filter of fixed size
+    FixedKalmanFilter<KalmanModel<ModelType>::StateSize> iBaseFilter;
 
-    //! Type of prediction
-    void InitFilter();
 public:
     ModifiedKalmanFilter();
-    ModifiedKalmanFilter(const enum KalmanFilterType aType);
     ~ModifiedKalmanFilter();
 
     void SetInitialPosition(cv::Point aCenter);
@@ -53,4 +62,7 @@ public:
     cv::Point GetCorrectedCenter() const;
 };
 
+extern template class ModifiedKalmanFilter<E_constant_velocity>;
+extern template class ModifiedKalmanFilter<E_constant_acceleration>;
+
 #endif //__MODIFIEDKALMANFILTER_HPP__
\ No newline at end of file
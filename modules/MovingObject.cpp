@@ -10,11 +10,18 @@
 MovingObject::MovingObject() :
         iHidden(false)
 {
-    InitFilter();
+    InitFilter(nullptr);
     InitIdentifier();
 }
 
 MovingObject::MovingObject(cv::Point aTopLeft, cv::Point aBottomRight) :
+        MovingObject(aTopLeft, aBottomRight, nullptr)
+{
+
+}
+
+MovingObject::MovingObject(cv::Point aTopLeft, cv::Point aBottomRight, TrackingContext *aContext) :
+        iObjectTrack(aContext != nullptr ? aContext->GetTrackLength() : TrackHistory::iDefaultCapacity),
         iHidden(false)
 {
     iTopLeft = aTopLeft;
@@ -24,7 +31,7 @@ MovingObject::MovingObject(cv::Point aTopLeft, cv::Point aBottomRight) :
     iCenter = iTopLeft;
     iCenter.x += iWidth/2;
     iCenter.y += iHeight/2;
-    InitFilter();
+    InitFilter(aContext);
     InitIdentifier();
 }
 
@@ -34,40 +41,43 @@ void MovingObject::InitIdentifier()
     iIdentifier = std::to_string(random_number);
 }
 
-void MovingObject::InitFilter()
+void MovingObject::InitFilter(TrackingContext *aContext)
 {
-    //iFilter = new ModifiedKalmanFilter(E_constant_velocity);
+    //iFilter = new ModifiedKalmanFilter<E_constant_velocity>();
     //iFilter = new MapBasedTracker();
-    iFilter = new MultipleTracker(E_doubleKalman_singleMap);
+    //iFilter = new MultipleTracker(E_doubleKalman_singleMap);
+    if(aContext != nullptr)
+        iFilter = aContext->GetTrackerPool().Create<FusedTopology<E_doubleKalman_singleMap>::Batched>(aContext);
+    else
+        iFilter.reset(new FusedTopology<E_doubleKalman_singleMap>::Standalone());
     iFilter->SetInitialPosition(iCenter);
 }
 
 MovingObject::~MovingObject()
 {
-    delete iFilter;
+
 }
 
 MovingMultiObject::~MovingMultiObject()
 {
-    for(auto object_iter : iObjects)
-        if(object_iter != nullptr) delete object_iter;
+
 }
 
 void MovingObject::PredictPosition()
 {
-    size_t track = iObjectTrack.size();
+    size_t track = iObjectTrack.Size();
     double angle = 0;
     if(track > 5)
     {
         angle = Map::CalcAngle(
-                iObjectTrack[track-1].y - iObjectTrack[track-5].y,
-                iObjectTrack[track-1].x - iObjectTrack[track-5].x
+                iObjectTrack.FromBack(0).y - iObjectTrack.FromBack(4).y,
+                iObjectTrack.FromBack(0).x - iObjectTrack.FromBack(4).x
         );
     }else if(track > 1)
     {
         angle = Map::CalcAngle(
-                iObjectTrack[track-1].y - iObjectTrack[track-2].y,
-                iObjectTrack[track-1].x - iObjectTrack[track-2].x
+                iObjectTrack.FromBack(0).y - iObjectTrack.FromBack(1).y,
+                iObjectTrack.FromBack(0).x - iObjectTrack.FromBack(1).x
         );
     }
     iFilter->Predict(angle);
@@ -77,12 +87,12 @@ void MovingObject::PredictPosition()
 void MovingObject::CorrectPosition(cv::Point aCenter)
 {
     iFilter->Correct(aCenter);
-    iObjectTrack.push_back(iFilter->GetCorrectedCenter());
+    iObjectTrack.Push(iFilter->GetCorrectedCenter());
 }
 
 void MovingObject::NoCorrection()
 {
-    iObjectTrack.push_back(iPredictedCenter);
+    iObjectTrack.Push(iPredictedCenter);
 
     iTopLeft.x = iPredictedCenter.x - iWidth/2;
     iTopLeft.y = iPredictedCenter.y - iHeight/2;
@@ -113,9 +123,15 @@ MovingMultiObject::MovingMultiObject(cv::Point aTopLeft, cv::Point aBottomRight)
     iCenter.y += iHeight/2;
 }
 
+MovingMultiObject::MovingMultiObject(cv::Point aTopLeft, cv::Point aBottomRight, TrackingContext *aContext) :
+        MovingObject(aTopLeft, aBottomRight, aContext)
+{
+
+}
+
 void MovingMultiObject::PredictPosition()
 {
-    for(MovingObject* iterator : iObjects)
+    for(ObjectPtr& iterator : iObjects)
     {
         iterator->PredictPosition();
     }
@@ -123,13 +139,13 @@ void MovingMultiObject::PredictPosition()
 
 void MovingMultiObject::NoCorrection()
 {
-    for(MovingObject* iterator : iObjects)
+    for(ObjectPtr& iterator : iObjects)
         iterator->NoCorrection();
 }
 
-void MovingMultiObject::AddNewObject(MovingObject *aObject)
+void MovingMultiObject::AddNewObject(ObjectPtr aObject)
 {
-    iObjects.push_back(aObject);
+    iObjects.push_back(std::move(aObject));
 }
 
 void MovingMultiObject::putTogetherIdentifiers()
@@ -19,7 +19,15 @@
 #include "ModifiedKalmanFilter.hpp"
 #include "MapBasedTracker.hpp"
 #include "MultipleTracker.hpp"
+#include "FusedTracker.hpp"
+#include "TrackingContext.hpp"
+#include "ObjectPool.hpp"
+#include "TrackHistory.hpp"
 
+class MovingObject;
+
+//! Owning pointer to object, objects of TrackerCore are allocated from the pool of TrackingContext
+typedef PoolPtr<MovingObject> ObjectPtr;
 
 /*!
  * \class MovingObject
@@ -28,11 +36,11 @@
 class MovingObject
 {
 private:
-    TrackerBase *iFilter;
-    std::vector<cv::Point> iObjectTrack;
+    PoolPtr<TrackerBase> iFilter;
+    TrackHistory iObjectTrack;
 
     void InitIdentifier();
-    void InitFilter();
+    void InitFilter(TrackingContext *aContext);
 
 protected:
     cv::Point iCenter, iTopLeft, iBottomRight, iPredictedCenter;
@@ -45,6 +53,8 @@ public:
     MovingObject();
     /// Constructor with geometric parameters of object
     MovingObject(cv::Point aTopLeft, cv::Point aBottomRight);
+    /// Constructor with geometric parameters of object, filters are batched in the context (see TrackingContext)
+    MovingObject(cv::Point aTopLeft, cv::Point aBottomRight, TrackingContext *aContext);
     /// Destructor
     virtual ~MovingObject();
 
@@ -74,8 +84,8 @@ public:
 
     /// Returns predicted center
     const cv::Point& getPredictedCenter() const {return iPredictedCenter;}
-    /// Returns object track as vector of points in frame
-    const std::vector<cv::Point>& getObjectTrack() const {return iObjectTrack;}
+    /// Returns last positions of object in frame, number of positions is limited (see TrackingContext#SetTrackLength)
+    const TrackHistory& getObjectTrack() const {return iObjectTrack;}
 
     /// Set object as hidden and reset hidden counter
     void SetAsHidden(void) {iHidden = true; iHiddenCounter=0;}
@@ -87,7 +97,7 @@ public:
     int GetHiddenCounter(void) const {return iHiddenCounter;}
 
     /// Throws an exception if this method is called
-    virtual std::vector<MovingObject *>& GetObjectsInside()
+    virtual std::vector<ObjectPtr>& GetObjectsInside()
     {
         throw std::logic_error("Invalid call of method GetObjectsInside.");
     }
@@ -100,9 +110,11 @@ public:
 class MovingMultiObject : public MovingObject
 {
 private:
-    std::vector<MovingObject *> iObjects;
+    std::vector<ObjectPtr> iObjects;
 public:
     MovingMultiObject(cv::Point aTopLeft, cv::Point aBottomRight);
+    /// Constructor, filter of multi-object is allocated from the context
+    MovingMultiObject(cv::Point aTopLeft, cv::Point aBottomRight, TrackingContext *aContext);
     ~MovingMultiObject();
     virtual bool IsSingleObject() {return false;}
 
@@ -110,9 +122,9 @@ public:
     void NoCorrection();
 
     /// Insert new object to vector of objects inside
-    void AddNewObject(MovingObject *aObject);
+    void AddNewObject(ObjectPtr aObject);
     /// Return vector of objects
-    virtual std::vector<MovingObject *>& GetObjectsInside() { return iObjects; }
+    virtual std::vector<ObjectPtr>& GetObjectsInside() { return iObjects; }
     /// Create new identifier using identifiers of objects inside
     void putTogetherIdentifiers();
 };
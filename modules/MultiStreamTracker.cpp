@@ -0,0 +1,159 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <iostream>
+
+#include "MultiStreamTracker.hpp"
+#include "TrackerFiles.hpp"
+
+MultiStreamTracker::MultiStreamTracker(unsigned int aThreadCount) :
+        iThreadCount(aThreadCount),
+        iFramesPerTask(1),
+        iWriteOutput(false),
+        iEncoding(E_double_cell),
+        iTileSize(0),
+        iAnalysisScale(1.0),
+        iAssociationMode(E_greedy_association),
+        iRunningStreams(0)
+{
+
+}
+
+void MultiStreamTracker::SetMapStorage(MapCellEncoding aEncoding, unsigned int aTileSize)
+{
+    iEncoding = aEncoding;
+    iTileSize = aTileSize;
+}
+
+bool MultiStreamTracker::AddStream(const std::string &aVideoFile)
+{
+    //File names are created in the same way as for a single video
+    size_t dot = aVideoFile.rfind('.');
+    if(dot == std::string::npos || dot == 0)
+    {
+        std::cerr << "[ERROR] Unknown file name or suffix " << aVideoFile << "!" << std::endl;
+        return(false);
+    }
+    TrackerFiles files;
+    files.setFilePath("");
+    files.setVideoName(aVideoFile.substr(0, dot));
+    files.setVideoSuffix(aVideoFile.substr(dot));
+    files.setOutputVideoSuffix("_output.avi");
+    files.setImageSuffix(".jpg");
+    files.setMapSuffix(".map");
+    files.setHiddenMaskSuffix(".mask.jpg");
+    files.setRoiMaskSuffix(".roi.jpg");
+
+    std::unique_ptr<Stream> stream(new Stream());
+    stream->Name = aVideoFile;
+    stream->ProcessedFrames = 0;
+    stream->Processor = std::make_shared<VideoProcessor>(false);
+    stream->Processor->SetMapEncoding(iEncoding);
+    stream->Processor->SetMapTileSize(iTileSize);
+    stream->Processor->SetAnalysisScale(iAnalysisScale);
+    //Stream is processed by a worker of the pool, nested parallel pre-processing would oversubscribe the cores
+    stream->Processor->SetParallelPreProcessing(false);
+    if(!stream->Processor->OpenFile(files.getVideoName()))
+    {
+        std::cerr << "[ERROR] Cannot open video file " << files.getVideoName() << "!" << std::endl;
+        return(false);
+    }
+    if(!stream->Processor->OpenBackgroundImage(files.getImageName()))
+    {
+        std::cerr << "[ERROR] Cannot open bg image " << files.getImageName() << "!" << std::endl;
+        return(false);
+    }
+    if(!stream->Processor->OpenHiddenMask(files.getHiddenMaskName()))
+    {
+        std::cerr << "[ERROR] Cannot open hidden mask " << files.getHiddenMaskName() << "!" << std::endl;
+        return(false);
+    }
+    stream->Processor->OpenRoiMask(files.getRoiMaskName());
+    if(iWriteOutput && !stream->Processor->SetOutputFile(files.getOutputVideoName()))
+        std::cerr << "[ERROR] Cannot open output video file " << files.getOutputVideoName() << "!" << std::endl;
+
+    stream->VelocityMap = stream->Processor->GetMap();
+    stream->VelocityMap->SetFileName(files.getMapName());
+    stream->VelocityMap->LoadMap(files.getTextMapName());
+
+    stream->Tracker.reset(new TrackerCore());
+    stream->Tracker->SetVideoProcessor(stream->Processor);
+    stream->Tracker->SetHiddenMask(stream->Processor->GetHiddenMask());
+    stream->Tracker->SetMap(stream->VelocityMap);
+    stream->Tracker->SetAssociationMode(iAssociationMode);
+
+    iStreams.push_back(std::move(stream));
+    return(true);
+}
+
+void MultiStreamTracker::FinishStream(Stream &aStream, std::exception_ptr aError)
+{
+    aStream.VelocityMap->SaveMap();
+
+    std::lock_guard<std::mutex> lock(iDoneMutex);
+    if(aError && !iError)
+        iError = aError;
+    --iRunningStreams;
+    if(iRunningStreams == 0)
+        iAllDone.notify_all();
+}
+
+void MultiStreamTracker::ProcessStream(WorkStealingPool &aPool, Stream &aStream)
+{
+    try
+    {
+        for(unsigned int i = 0; i < iFramesPerTask; ++i)
+        {
+            if(!aStream.Processor->ReadNextFrame())
+            {
+                FinishStream(aStream);
+                return;
+            }
+
+            aStream.Tracker->TrackObjects();
+            if(aStream.Processor->IsOutputEnabled())
+            {
+                aStream.Tracker->DrawObjects();
+                aStream.Processor->DisplayOutput();
+            }
+            ++aStream.ProcessedFrames;
+        }
+    }catch(...){
+        //Stream is finished, error is rethrown by Run
+        FinishStream(aStream, std::current_exception());
+        return;
+    }
+
+    //Continuation goes to the back of the queue, so the other streams run before the next frames of this one
+    aPool.Submit([this, &aPool, &aStream]{ ProcessStream(aPool, aStream); });
+}
+
+unsigned long MultiStreamTracker::Run()
+{
+    if(iStreams.empty())
+        return(0);
+
+    {
+        WorkStealingPool pool(iThreadCount);
+        iRunningStreams = iStreams.size();
+        iError = nullptr;
+        for(std::unique_ptr<Stream> &stream : iStreams)
+        {
+            Stream *stream_pointer = stream.get();
+            pool.Submit([this, &pool, stream_pointer]{ ProcessStream(pool, *stream_pointer); });
+        }
+
+        std::unique_lock<std::mutex> lock(iDoneMutex);
+        iAllDone.wait(lock, [this]{ return iRunningStreams == 0; });
+    }
+
+    if(iError)
+        std::rethrow_exception(iError);
+
+    unsigned long processed_frames = 0;
+    for(std::unique_ptr<Stream> &stream : iStreams)
+        processed_frames += stream->ProcessedFrames;
+    return processed_frames;
+}
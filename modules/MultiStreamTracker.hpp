@@ -0,0 +1,107 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class MultiStreamTracker
+ *
+ */
+
+#ifndef __MULTISTREAMTRACKER_HPP__
+#define __MULTISTREAMTRACKER_HPP__
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "VideoProcessor.hpp"
+#include "TrackerCore.hpp"
+#include "WorkStealingPool.hpp"
+
+/*!
+ * \class MultiStreamTracker
+ * \brief Tracks objects in many videos (camera streams) in one process
+ *
+ * Every stream has its own VideoProcessor, velocity map and TrackerCore, so streams do not share any state.
+ * Frames of all streams are processed by one WorkStealingPool. Each stream has at most one task in the pool,
+ * the task processes a few frames and submits its continuation to the back of the queue. Frames of a stream
+ * are therefore processed in order, and streams take turns, so no stream is starved by the others.
+ *
+ * Streams are processed in headless mode, only the output video is written if it is enabled.
+ */
+class MultiStreamTracker
+{
+private:
+    struct Stream
+    {
+        std::string Name;
+        std::shared_ptr<VideoProcessor> Processor;
+        std::shared_ptr<Map> VelocityMap;
+        std::unique_ptr<TrackerCore> Tracker;
+        unsigned long ProcessedFrames;
+    };
+
+    std::vector<std::unique_ptr<Stream>> iStreams;
+    unsigned int iThreadCount;
+    unsigned int iFramesPerTask;
+    bool iWriteOutput;
+    MapCellEncoding iEncoding;
+    unsigned int iTileSize;
+    double iAnalysisScale;
+    AssociationMode iAssociationMode;
+
+    std::mutex iDoneMutex;
+    std::condition_variable iAllDone;
+    size_t iRunningStreams;
+    std::exception_ptr iError;
+
+    void ProcessStream(WorkStealingPool &aPool, Stream &aStream);
+    void FinishStream(Stream &aStream, std::exception_ptr aError = nullptr);
+
+public:
+    //! Constructor, number of threads is taken from the hardware if aThreadCount is 0
+    explicit MultiStreamTracker(unsigned int aThreadCount = 0);
+
+    //! Set number of frames which a stream processes before it lets other streams run (1 by default)
+    void SetFramesPerTask(unsigned int aFrames) { iFramesPerTask = aFrames > 0 ? aFrames : 1; }
+
+    //! Turn on writing of output video of streams added after this call
+    void SetOutputEnabled(bool aEnabled) { iWriteOutput = aEnabled; }
+
+    //! Set encoding and tile size of maps of streams added after this call (see Map constructor)
+    void SetMapStorage(MapCellEncoding aEncoding, unsigned int aTileSize);
+
+    //! Set analysis scale of streams added after this call (see VideoProcessor#SetAnalysisScale)
+    void SetAnalysisScale(double aScale) { iAnalysisScale = aScale; }
+
+    //! Set association mode of streams added after this call (see TrackerCore#SetAssociationMode)
+    void SetAssociationMode(AssociationMode aMode) { iAssociationMode = aMode; }
+
+    /*!
+     * \brief Open video file with its background image, hidden mask and map (see TrackerFiles)
+     *
+     * Return false if the video, background image or hidden mask cannot be opened.
+     */
+    bool AddStream(const std::string &aVideoFile);
+
+    //! Return number of streams
+    size_t GetStreamCount() const { return iStreams.size(); }
+
+    //! Return name of video of the stream
+    const std::string &GetStreamName(size_t aIndex) const { return iStreams[aIndex]->Name; }
+
+    //! Return number of frames processed in the stream
+    unsigned long GetProcessedFrames(size_t aIndex) const { return iStreams[aIndex]->ProcessedFrames; }
+
+    /*!
+     * \brief Process all streams to their end and save their maps, return number of processed frames of all streams
+     *
+     * Stream which throws an exception is stopped, the other streams are finished and then the first exception
+     * is rethrown.
+     */
+    unsigned long Run();
+};
+
+#endif //__MULTISTREAMTRACKER_HPP__
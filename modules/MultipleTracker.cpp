@@ -6,64 +6,75 @@
 #include "MultipleTracker.hpp"
 #include "ModifiedKalmanFilter.hpp"
 #include "MapBasedTracker.hpp"
+#include "BatchedKalmanFilter.hpp"
+#include "TrackingContext.hpp"
 
-MultipleTracker::MultipleTracker()
+MultipleTracker::MultipleTracker() :
+        iTrackerCount(0)
 {
-    ModifiedKalmanFilter *first = new ModifiedKalmanFilter(E_constant_velocity);
-    MapBasedTracker *second = new MapBasedTracker();
-    iTrackers.push_back(first);
-    iTrackers.push_back(second);
+    AddTracker(PoolPtr<TrackerBase>(new ModifiedKalmanFilter<E_constant_velocity>()));
+    AddTracker(PoolPtr<TrackerBase>(new MapBasedTracker()));
 }
 
-MultipleTracker::MultipleTracker(const enum MultipleTrackerType aType)
+MultipleTracker::MultipleTracker(const enum MultipleTrackerType aType) :
+        iTrackerCount(0)
 {
     if(aType == E_doubleKalman_singleMap)
     {
-        ModifiedKalmanFilter *first = new ModifiedKalmanFilter(E_constant_velocity);
-        ModifiedKalmanFilter *second = new ModifiedKalmanFilter(E_constant_acceleration);
-        MapBasedTracker *third = new MapBasedTracker();
-        iTrackers.push_back(first);
-        iTrackers.push_back(second);
-        iTrackers.push_back(third);
+        AddTracker(PoolPtr<TrackerBase>(new ModifiedKalmanFilter<E_constant_velocity>()));
+        AddTracker(PoolPtr<TrackerBase>(new ModifiedKalmanFilter<E_constant_acceleration>()));
+        AddTracker(PoolPtr<TrackerBase>(new MapBasedTracker()));
     }else{
-        ModifiedKalmanFilter *first = new ModifiedKalmanFilter(E_constant_velocity);
-        MapBasedTracker *second = new MapBasedTracker();
-        iTrackers.push_back(first);
-        iTrackers.push_back(second);
+        AddTracker(PoolPtr<TrackerBase>(new ModifiedKalmanFilter<E_constant_velocity>()));
+        AddTracker(PoolPtr<TrackerBase>(new MapBasedTracker()));
     }
 }
 
+MultipleTracker::MultipleTracker(const enum MultipleTrackerType aType, TrackingContext &aContext) :
+        iTrackerCount(0)
+{
+    ObjectPool &pool = aContext.GetTrackerPool();
+    AddTracker(pool.Create<BatchedKalmanFilter<E_constant_velocity>>(aContext.GetVelocityEngine()));
+    if(aType == E_doubleKalman_singleMap)
+        AddTracker(pool.Create<BatchedKalmanFilter<E_constant_acceleration>>(aContext.GetAccelerationEngine()));
+    AddTracker(pool.Create<MapBasedTracker>(aContext.GetMap()));
+}
+
 MultipleTracker::~MultipleTracker()
 {
-    for(auto& iterator : iTrackers)
-        delete iterator;
+
+}
+
+void MultipleTracker::AddTracker(PoolPtr<TrackerBase> aTracker)
+{
+    iTrackers[iTrackerCount++] = std::move(aTracker);
 }
 
 void MultipleTracker::SetInitialPosition(cv::Point aCenter)
 {
-    for(auto& iterator : iTrackers)
-        iterator->SetInitialPosition(aCenter);
+    for(size_t i = 0; i < iTrackerCount; ++i)
+        iTrackers[i]->SetInitialPosition(aCenter);
 }
 
 void MultipleTracker::Predict(double aAngle)
 {
-    for(auto& iterator : iTrackers)
-        iterator->Predict(aAngle);
+    for(size_t i = 0; i < iTrackerCount; ++i)
+        iTrackers[i]->Predict(aAngle);
 }
 
 void MultipleTracker::Correct(cv::Point aCenter)
 {
-    for(auto& iterator : iTrackers)
-        iterator->Correct(aCenter);
+    for(size_t i = 0; i < iTrackerCount; ++i)
+        iTrackers[i]->Correct(aCenter);
 }
 
 cv::Point MultipleTracker::GetPredictedCenter() const
 {
     cv::Point center;
-    double coefficient = 1.0/(double)(iTrackers.size());
-    for(auto& iterator : iTrackers)
+    double coefficient = 1.0/(double)(iTrackerCount);
+    for(size_t i = 0; i < iTrackerCount; ++i)
     {
-        center += coefficient*iterator->GetPredictedCenter();
+        center += coefficient*iTrackers[i]->GetPredictedCenter();
     }
 
     return center;
@@ -72,10 +83,10 @@ cv::Point MultipleTracker::GetPredictedCenter() const
 cv::Point MultipleTracker::GetCorrectedCenter() const
 {
     cv::Point center;
-    double coefficient = 1.0/(double)(iTrackers.size());
-    for(auto& iterator : iTrackers)
+    double coefficient = 1.0/(double)(iTrackerCount);
+    for(size_t i = 0; i < iTrackerCount; ++i)
     {
-        center += coefficient*iterator->GetPredictedCenter();
+        center += coefficient*iTrackers[i]->GetPredictedCenter();
     }
 
     return center;
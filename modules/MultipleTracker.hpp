@@ -11,9 +11,12 @@
 
 
 #include "TrackerBase.hpp"
+#include "ObjectPool.hpp"
 #include <opencv2/core/core.hpp>
 #include <vector>
 
+class TrackingContext;
+
 //! Defines two possible types of multiple tracker topology
 enum MultipleTrackerType
 {
@@ -24,20 +27,31 @@ enum MultipleTrackerType
 /*!
  * \class MultipleTracker
  * \brief Tracker which includes one or two Kalman filters and one map based tracker
+ *
+ * Topology is chosen at run time. FusedTracker (see FusedTopology) implements the same topologies chosen at compile
+ * time without virtual calls of the trackers inside.
  */
 class MultipleTracker : public TrackerBase
 {
 private:
 
-    std::vector<TrackerBase *> iTrackers;
+    //! Trackers are in a fixed array, so the whole tracker stack does not allocate anything besides its blocks
+    PoolPtr<TrackerBase> iTrackers[3];
+    size_t iTrackerCount;
+
+    void AddTracker(PoolPtr<TrackerBase> aTracker);
 
 public:
-    /// Constructor, implicit type is E_singleKalman_singleMap
+    /// Constructor, implicit type is E_singleKalman_singleMap, map based tracker has no map (see MapBasedTracker)
     MultipleTracker();
 
     /// Constructor with type switch
     MultipleTracker(const enum MultipleTrackerType aType);
 
+    /// Constructor with type switch, Kalman filters are stored in engines of the context (see BatchedKalmanFilter),
+    /// map based tracker uses map of the context and the trackers are allocated from its pool
+    MultipleTracker(const enum MultipleTrackerType aType, TrackingContext &aContext);
+
     /// Destructor
     ~MultipleTracker();
 
@@ -0,0 +1,50 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "ObjectPool.hpp"
+
+ObjectPool::ObjectPool(size_t aBlockSize, size_t aBlocksPerChunk) :
+        iBlocksPerChunk(aBlocksPerChunk > 0 ? aBlocksPerChunk : 1),
+        iFreeBlocks(nullptr),
+        iUsedBlocks(0)
+{
+    //Blocks keep alignment of memory from new and they hold the pointer to the next free block
+    const size_t alignment = alignof(std::max_align_t);
+    iBlockSize = std::max(aBlockSize, sizeof(void *));
+    iBlockSize = (iBlockSize + alignment - 1)/alignment*alignment;
+}
+
+void *ObjectPool::Allocate(size_t aSize)
+{
+    if(aSize > iBlockSize)
+        throw std::invalid_argument("Object is larger than block of the pool.");
+
+    if(iFreeBlocks == nullptr)
+    {
+        iChunks.emplace_back(new unsigned char[iBlockSize*iBlocksPerChunk]);
+        unsigned char *chunk = iChunks.back().get();
+        for(size_t i = iBlocksPerChunk; i > 0; --i)
+        {
+            void *block = chunk + (i - 1)*iBlockSize;
+            *static_cast<void **>(block) = iFreeBlocks;
+            iFreeBlocks = block;
+        }
+    }
+
+    void *block = iFreeBlocks;
+    iFreeBlocks = *static_cast<void **>(block);
+    ++iUsedBlocks;
+    return block;
+}
+
+void ObjectPool::Free(void *aBlock)
+{
+    *static_cast<void **>(aBlock) = iFreeBlocks;
+    iFreeBlocks = aBlock;
+    --iUsedBlocks;
+}
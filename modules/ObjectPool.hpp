@@ -0,0 +1,102 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class ObjectPool and deleter PoolDeleter
+ *
+ */
+
+#ifndef __OBJECTPOOL_HPP__
+#define __OBJECTPOOL_HPP__
+
+#include <memory>
+#include <vector>
+#include <utility>
+#include <cstddef>
+
+class ObjectPool;
+
+/*!
+ * \brief Deleter of std::unique_ptr for objects created by ObjectPool#Create
+ *
+ * Object is destroyed and its block is returned to the pool. Deleter without pool deletes objects created by new,
+ * so the same pointer type can hold both. Objects may be deleted through pointer to a base class with virtual
+ * destructor if the base class is at the beginning of the object (single inheritance).
+ */
+struct PoolDeleter
+{
+    ObjectPool *iPool;
+
+    PoolDeleter(ObjectPool *aPool = nullptr) : iPool(aPool) {}
+
+    template<typename T>
+    void operator()(T *aObject) const;
+};
+
+//! Owning pointer to an object from ObjectPool (or from new)
+template<typename T>
+using PoolPtr = std::unique_ptr<T, PoolDeleter>;
+
+/*!
+ * \class ObjectPool
+ * \brief Pool of memory blocks of the same size
+ *
+ * Blocks are allocated in chunks which are never returned until the pool is destroyed, free blocks form
+ * a linked list, so allocation and release are a few instructions without any call of the heap allocator.
+ * Pool is not thread safe, every TrackerCore has its own pools (see TrackingContext).
+ */
+class ObjectPool
+{
+private:
+    size_t iBlockSize, iBlocksPerChunk;
+    std::vector<std::unique_ptr<unsigned char[]>> iChunks;
+    void *iFreeBlocks;
+    size_t iUsedBlocks;
+
+public:
+    //! Constructor, blocks will be large enough for objects of aBlockSize bytes
+    ObjectPool(size_t aBlockSize, size_t aBlocksPerChunk = 256);
+
+    ObjectPool(const ObjectPool &) = delete;
+    ObjectPool &operator=(const ObjectPool &) = delete;
+
+    //! Return block for object of aSize bytes, throws std::invalid_argument if the object does not fit
+    void *Allocate(size_t aSize);
+
+    //! Return block to the pool
+    void Free(void *aBlock);
+
+    //! Construct object of type T in a block of the pool
+    template<typename T, typename... Args>
+    PoolPtr<T> Create(Args&&... aArgs)
+    {
+        void *block = Allocate(sizeof(T));
+        try
+        {
+            return PoolPtr<T>(new(block) T(std::forward<Args>(aArgs)...), PoolDeleter(this));
+        }catch(...){
+            Free(block);
+            throw;
+        }
+    }
+
+    //! Return number of blocks in use
+    size_t GetUsedCount() const { return iUsedBlocks; }
+
+    //! Return number of blocks in all chunks
+    size_t GetCapacity() const { return iChunks.size()*iBlocksPerChunk; }
+};
+
+template<typename T>
+void PoolDeleter::operator()(T *aObject) const
+{
+    if(iPool != nullptr)
+    {
+        aObject->~T();
+        iPool->Free(aObject);
+    }else{
+        delete aObject;
+    }
+}
+
+#endif //__OBJECTPOOL_HPP__
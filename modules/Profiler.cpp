@@ -0,0 +1,184 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "Profiler.hpp"
+
+Profiler::Profiler() :
+        iStart(Clock::now()),
+        iTraceEnabled(false)
+{
+
+}
+
+Profiler &Profiler::Instance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+Profiler::ThreadBuffer &Profiler::GetThreadBuffer()
+{
+    //Buffer is owned by the profiler, so events of finished threads are kept for the report
+    thread_local ThreadBuffer *buffer = nullptr;
+    if(buffer == nullptr)
+    {
+        std::shared_ptr<ThreadBuffer> new_buffer = std::make_shared<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(iBuffersMutex);
+        new_buffer->ThreadId = (unsigned int)iBuffers.size() + 1;
+        iBuffers.push_back(new_buffer);
+        buffer = new_buffer.get();
+    }
+    return *buffer;
+}
+
+void Profiler::AddSample(Statistics &aStatistics, double aValue, bool aHistogram)
+{
+    if(aStatistics.Count == 0)
+    {
+        aStatistics.Sum = 0;
+        aStatistics.Max = aValue;
+        std::fill(aStatistics.Histogram, aStatistics.Histogram + iHistogramBuckets, 0);
+    }
+    ++aStatistics.Count;
+    aStatistics.Sum += aValue;
+    aStatistics.Max = std::max(aStatistics.Max, aValue);
+    if(aHistogram)
+    {
+        int bucket = 0;
+        while(bucket < iHistogramBuckets - 1 && aValue >= double(1u << bucket))
+            ++bucket;
+        ++aStatistics.Histogram[bucket];
+    }
+}
+
+void Profiler::RecordScope(const char *aName, double aStart, double aDuration)
+{
+    ThreadBuffer &buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.Mutex);
+    AddSample(buffer.Stages[aName], aDuration, true);
+    if(iTraceEnabled)
+        buffer.Events.push_back(TraceEvent{aName, aStart, aDuration, false});
+}
+
+void Profiler::RecordCounter(const char *aName, double aValue)
+{
+    ThreadBuffer &buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(buffer.Mutex);
+    AddSample(buffer.Counters[aName], aValue, false);
+    if(iTraceEnabled)
+        buffer.Events.push_back(TraceEvent{aName, Now(), aValue, true});
+}
+
+void Profiler::MergeStatistics(std::unordered_map<std::string, Statistics> &aStages,
+                               std::unordered_map<std::string, Statistics> &aCounters)
+{
+    auto merge = [](std::unordered_map<std::string, Statistics> &aTarget,
+                    const std::unordered_map<const char*, Statistics> &aSource)
+    {
+        for(const auto &item : aSource)
+        {
+            auto inserted = aTarget.insert(std::make_pair(std::string(item.first), item.second));
+            if(inserted.second)
+                continue;
+            Statistics &target = inserted.first->second;
+            target.Count += item.second.Count;
+            target.Sum += item.second.Sum;
+            target.Max = std::max(target.Max, item.second.Max);
+            for(int i = 0; i < iHistogramBuckets; ++i)
+                target.Histogram[i] += item.second.Histogram[i];
+        }
+    };
+
+    std::lock_guard<std::mutex> lock(iBuffersMutex);
+    for(std::shared_ptr<ThreadBuffer> &buffer : iBuffers)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->Mutex);
+        merge(aStages, buffer->Stages);
+        merge(aCounters, buffer->Counters);
+    }
+}
+
+void Profiler::PrintReport(std::ostream &aStream)
+{
+    std::unordered_map<std::string, Statistics> stages, counters;
+    MergeStatistics(stages, counters);
+
+    //Percentile is the upper bound of its bucket, i.e. at most twice the real value
+    auto percentile = [](const Statistics &aStatistics, double aFraction)
+    {
+        unsigned long limit = (unsigned long)std::ceil(aStatistics.Count*aFraction), count = 0;
+        for(int i = 0; i < iHistogramBuckets; ++i)
+        {
+            count += aStatistics.Histogram[i];
+            if(count >= limit)
+                return std::min(double(1u << i), aStatistics.Max);
+        }
+        return aStatistics.Max;
+    };
+
+    std::map<std::string, Statistics> sorted_stages(stages.begin(), stages.end());
+    std::map<std::string, Statistics> sorted_counters(counters.begin(), counters.end());
+
+    aStream << std::fixed << std::setprecision(1);
+    aStream << std::left << std::setw(20) << "stage" << std::right << std::setw(10) << "count" << std::setw(12)
+            << "mean [us]" << std::setw(12) << "p50 <=" << std::setw(12) << "p95 <=" << std::setw(12) << "p99 <="
+            << std::setw(12) << "max [us]" << std::endl;
+    for(const auto &item : sorted_stages)
+    {
+        const Statistics &statistics = item.second;
+        aStream << std::left << std::setw(20) << item.first << std::right << std::setw(10) << statistics.Count
+                << std::setw(12) << statistics.Sum/statistics.Count << std::setw(12) << percentile(statistics, 0.5)
+                << std::setw(12) << percentile(statistics, 0.95) << std::setw(12) << percentile(statistics, 0.99)
+                << std::setw(12) << statistics.Max << std::endl;
+    }
+
+    if(sorted_counters.empty())
+        return;
+    aStream << std::left << std::setw(20) << "counter" << std::right << std::setw(10) << "samples" << std::setw(12)
+            << "mean" << std::setw(12) << "max" << std::endl;
+    for(const auto &item : sorted_counters)
+    {
+        const Statistics &statistics = item.second;
+        aStream << std::left << std::setw(20) << item.first << std::right << std::setw(10) << statistics.Count
+                << std::setw(12) << statistics.Sum/statistics.Count << std::setw(12) << statistics.Max << std::endl;
+    }
+}
+
+bool Profiler::WriteTrace(const std::string &aFileName)
+{
+    std::ofstream file(aFileName);
+    if(!file.is_open())
+        return(false);
+
+    //Names are literals in the source code, they need no escaping
+    file << "{\"traceEvents\":[\n" << std::fixed << std::setprecision(3);
+    bool first = true;
+    std::lock_guard<std::mutex> lock(iBuffersMutex);
+    for(std::shared_ptr<ThreadBuffer> &buffer : iBuffers)
+    {
+        std::lock_guard<std::mutex> buffer_lock(buffer->Mutex);
+        for(const TraceEvent &event : buffer->Events)
+        {
+            file << (first ? "" : ",\n");
+            first = false;
+            if(event.IsCounter)
+            {
+                file << "{\"name\":\"" << event.Name << "\",\"ph\":\"C\",\"ts\":" << event.Start
+                     << ",\"pid\":1,\"tid\":" << buffer->ThreadId << ",\"args\":{\"value\":" << event.Value << "}}";
+            }else{
+                file << "{\"name\":\"" << event.Name << "\",\"ph\":\"X\",\"ts\":" << event.Start
+                     << ",\"dur\":" << event.Value << ",\"pid\":1,\"tid\":" << buffer->ThreadId << "}";
+            }
+        }
+    }
+    file << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return(file.good());
+}
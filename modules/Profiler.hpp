@@ -0,0 +1,130 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class Profiler and macros of instrumentation
+ *
+ * Stages are measured by OT_PROFILE_SCOPE("name") at the beginning of a block, values per frame are recorded by
+ * OT_PROFILE_COUNTER("name", value). The macros are compiled only if OT_ENABLE_PROFILING is defined (CMake
+ * option ENABLE_PROFILING), otherwise they expand to nothing and their arguments are not evaluated.
+ * Names must be string literals, they are identified by their address.
+ */
+
+#ifndef __PROFILER_HPP__
+#define __PROFILER_HPP__
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <string>
+#include <ostream>
+#include <unordered_map>
+
+/*!
+ * \class Profiler
+ * \brief Collects duration of stages and values of counters from all threads
+ *
+ * Every thread records into its own buffer, so measuring a stage costs two clock reads and an update of a
+ * histogram without any contention. Durations are kept in histograms with buckets of powers of two
+ * microseconds, the report shows count, mean, approximate percentiles and maximum of every stage and mean
+ * and maximum of every counter.
+ *
+ * If trace is enabled, every measured scope and counter value is kept as an event and
+ * Profiler#WriteTrace writes them in Chrome trace event format (chrome://tracing, Perfetto).
+ */
+class Profiler
+{
+public:
+    static const int iHistogramBuckets = 32;   ///< Bucket i holds durations below 2^i microseconds
+
+    //! Statistics of one stage or counter
+    struct Statistics
+    {
+        unsigned long Count;
+        double Sum, Max;
+        unsigned long Histogram[iHistogramBuckets];
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct TraceEvent
+    {
+        const char *Name;
+        double Start, Value;    ///< Microseconds since start of profiler, duration or value of counter
+        bool IsCounter;
+    };
+
+    struct ThreadBuffer
+    {
+        std::mutex Mutex;       ///< Taken by the owning thread for every record, contended only by reports
+        unsigned int ThreadId;
+        std::unordered_map<const char*, Statistics> Stages, Counters;
+        std::vector<TraceEvent> Events;
+    };
+
+    Clock::time_point iStart;
+    bool iTraceEnabled;
+    std::mutex iBuffersMutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> iBuffers;
+
+    Profiler();
+    ThreadBuffer &GetThreadBuffer();
+    static void AddSample(Statistics &aStatistics, double aValue, bool aHistogram);
+    void MergeStatistics(std::unordered_map<std::string, Statistics> &aStages,
+                         std::unordered_map<std::string, Statistics> &aCounters);
+
+public:
+    //! Return profiler of the process
+    static Profiler &Instance();
+
+    //! Return microseconds since start of profiler
+    double Now() const { return std::chrono::duration<double, std::micro>(Clock::now() - iStart).count(); }
+
+    //! Turn on keeping of events for Profiler#WriteTrace, it should be called before processing starts
+    void SetTraceEnabled(bool aEnabled) { iTraceEnabled = aEnabled; }
+
+    //! Record duration of a stage in microseconds
+    void RecordScope(const char *aName, double aStart, double aDuration);
+
+    //! Record value of a counter
+    void RecordCounter(const char *aName, double aValue);
+
+    //! Write table of stages and counters
+    void PrintReport(std::ostream &aStream);
+
+    //! Write recorded events in Chrome trace event format, return false if the file cannot be written
+    bool WriteTrace(const std::string &aFileName);
+};
+
+/*!
+ * \class ProfileScope
+ * \brief Measures time from its construction to its destruction, created by OT_PROFILE_SCOPE
+ */
+class ProfileScope
+{
+private:
+    const char *iName;
+    double iStart;
+
+public:
+    explicit ProfileScope(const char *aName) : iName(aName), iStart(Profiler::Instance().Now()) {}
+    ~ProfileScope() { Profiler::Instance().RecordScope(iName, iStart, Profiler::Instance().Now() - iStart); }
+
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+};
+
+#define OT_PROFILE_CONCAT_(a, b) a##b
+#define OT_PROFILE_CONCAT(a, b) OT_PROFILE_CONCAT_(a, b)
+
+#ifdef OT_ENABLE_PROFILING
+#define OT_PROFILE_SCOPE(name) ProfileScope OT_PROFILE_CONCAT(ot_profile_scope_, __LINE__)(name)
+#define OT_PROFILE_COUNTER(name, value) Profiler::Instance().RecordCounter((name), double(value))
+#else
+#define OT_PROFILE_SCOPE(name) do {} while(0)
+#define OT_PROFILE_COUNTER(name, value) do {} while(0)
+#endif
+
+#endif //__PROFILER_HPP__
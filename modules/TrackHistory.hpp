@@ -0,0 +1,83 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration and implementation of class TrackHistory
+ *
+ */
+
+#ifndef __TRACKHISTORY_HPP__
+#define __TRACKHISTORY_HPP__
+
+#include <vector>
+#include <cstddef>
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \class TrackHistory
+ * \brief Last positions of an object in a ring buffer of fixed capacity
+ *
+ * When the buffer is full, every new position overwrites the oldest one, so an object which is tracked for a long
+ * time does not take more memory and drawing of its track does not take more time. Buffer is allocated by the first
+ * TrackHistory#Push, objects which are never corrected (most of new blobs) do not allocate anything.
+ *
+ * Positions are indexed from the oldest one by operator[] or from the newest one by TrackHistory#FromBack.
+ */
+class TrackHistory
+{
+private:
+    std::vector<cv::Point> iPoints;
+    size_t iCapacity, iFirst, iSize;
+
+public:
+    static const size_t iDefaultCapacity = 64;  ///< Default number of stored positions
+    static const size_t iMinimalCapacity = 8;   ///< MovingObject#PredictPosition needs the last five positions
+    static const size_t iMaximalCapacity = 1 << 16; ///< Limit of capacity, buffer of every object takes 512 kB
+
+    //! Constructor, capacity is limited to #iMinimalCapacity..#iMaximalCapacity
+    explicit TrackHistory(size_t aCapacity = iDefaultCapacity) :
+            iCapacity(aCapacity < iMinimalCapacity ? size_t(iMinimalCapacity) :
+                      (aCapacity > iMaximalCapacity ? size_t(iMaximalCapacity) : aCapacity)),
+            iFirst(0),
+            iSize(0)
+    {
+
+    }
+
+    //! Append position, the oldest position is dropped if the buffer is full
+    void Push(const cv::Point &aPoint)
+    {
+        if(iPoints.empty())
+            iPoints.resize(iCapacity);
+
+        if(iSize < iCapacity)
+        {
+            iPoints[(iFirst + iSize) % iCapacity] = aPoint;
+            ++iSize;
+        }else{
+            iPoints[iFirst] = aPoint;
+            iFirst = (iFirst + 1) % iCapacity;
+        }
+    }
+
+    //! Remove all positions, the buffer is kept
+    void Clear() { iFirst = 0; iSize = 0; }
+
+    //! Return i-th position from the oldest one
+    const cv::Point &operator[](size_t aIndex) const { return iPoints[(iFirst + aIndex) % iCapacity]; }
+
+    //! Return i-th position from the newest one
+    const cv::Point &FromBack(size_t aIndex) const { return (*this)[iSize - 1 - aIndex]; }
+
+    //! Return number of stored positions
+    size_t Size() const { return iSize; }
+
+    //! Return true if there is no position
+    bool Empty() const { return iSize == 0; }
+
+    //! Return maximal number of stored positions
+    size_t Capacity() const { return iCapacity; }
+};
+
+#endif //__TRACKHISTORY_HPP__
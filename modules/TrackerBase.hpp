@@ -8,8 +8,6 @@
 #ifndef _OBJECTTRACKER_FILTERBASE_H_
 #define _OBJECTTRACKER_FILTERBASE_H_
 
-#include <memory>
-
 #include <opencv2/core/core.hpp>
 
 #include "Map.hpp"
@@ -19,20 +17,13 @@
  * \brief Abstract class that defines tracking algorithm
  *
  * This class is used as an interface for modified Kalman filter
- * and map based tracking.
+ * and map based tracking. Trackers do not share any static state, map is given to MapBasedTracker
+ * by its constructor.
  *
  */
 class TrackerBase
 {
-protected:
-    static std::shared_ptr<Map> iMap;
-
 public:
-    //! This method sets pointer to the instance of map
-    static void SetMapPointer(std::shared_ptr<Map> aMap)
-    {
-        iMap=aMap;
-    }
     virtual ~TrackerBase(){};
 
     //! Set object's initial position
@@ -3,9 +3,16 @@
  * \author Martin Sehnoutka
  */
 
+#include <algorithm>
+
 #include "TrackerCore.hpp"
+#include "Profiler.hpp"
 
-TrackerCore::TrackerCore()
+TrackerCore::TrackerCore() :
+        iGridColumns(1),
+        iGridRows(1),
+        iAssociationMode(E_greedy_association),
+        iTrackRecorder(nullptr)
 {
 
 }
@@ -18,17 +25,106 @@ TrackerCore::~TrackerCore()
 
 void TrackerCore::TrackObjects()
 {
-    InitObjects();
+    TrackObjects(iVideoProcessor->GetCurrentFrame());
+}
+
+void TrackerCore::TrackObjects(const VideoFrame &aFrame)
+{
+    OT_PROFILE_SCOPE("track");
+    {
+        OT_PROFILE_SCOPE("kalman predict");
+        iTrackingContext.PredictAll();
+    }
+    InitObjects(aFrame);
+    OT_PROFILE_COUNTER("blobs", iNewObjects.size());
+    PairObjects();
+    if(iTrackRecorder != nullptr)
+        RecordTracks(aFrame.Index);
+
+#ifdef OT_ENABLE_PROFILING
+    size_t multi_objects = 0, hidden_objects = 0;
+    for(const ObjectPtr &object : iObjects)
+    {
+        if(!object->IsSingleObject())
+            ++multi_objects;
+        else if(object->IsHidden())
+            ++hidden_objects;
+    }
+    OT_PROFILE_COUNTER("objects", iObjects.size());
+    OT_PROFILE_COUNTER("multi-objects", multi_objects);
+    OT_PROFILE_COUNTER("hidden objects", hidden_objects);
+#endif
+}
+
+void TrackerCore::TrackDetections(const std::vector<cv::Rect> &aDetections, unsigned long aFrameIndex)
+{
+    OT_PROFILE_SCOPE("track");
+    iTrackingContext.PredictAll();
+
+    ObjectPool &object_pool = iTrackingContext.GetObjectPool();
+    for(const cv::Rect &detection : aDetections)
+        iNewObjects.push_back(object_pool.Create<MovingObject>(detection.tl(), detection.br(), &iTrackingContext));
+
     PairObjects();
+    if(iTrackRecorder != nullptr)
+        RecordTracks(aFrameIndex);
+}
+
+void TrackerCore::PredictObjects()
+{
+    PredictObjects(iVideoProcessor->GetCurrentFrame());
+}
+
+void TrackerCore::PredictObjects(const VideoFrame &aFrame)
+{
+    OT_PROFILE_SCOPE("predict only");
+    //No blobs are searched, all objects continue as if they were hidden in this frame
+    iTrackingContext.PredictAll();
+    for(ObjectPtr &object : iObjects)
+    {
+        object->PredictPosition();
+        object->NoCorrection();
+    }
+    iTrackingContext.CorrectAll();
+    if(iTrackRecorder != nullptr)
+        RecordTracks(aFrame.Index);
+}
+
+void TrackerCore::RecordTracks(unsigned long aFrameIndex)
+{
+    auto record_single_object = [this, aFrameIndex](const ObjectPtr &aSingle_object)->void
+    {
+        const TrackHistory &track = aSingle_object->getObjectTrack();
+        if(track.Empty())
+            return;
+        *iTrackRecorder << aFrameIndex << " " << aSingle_object->getIdentifier() << " "
+                << track.FromBack(0).x << " " << track.FromBack(0).y << "\n";
+    };
+
+    for(ObjectPtr& object_iterator : iObjects)
+    {
+        if(object_iterator->IsSingleObject())
+        {
+            record_single_object(object_iterator);
+        }else{
+            for(ObjectPtr& object_inside : object_iterator->GetObjectsInside())
+                record_single_object(object_inside);
+        }
+    }
 }
 
 void TrackerCore::DrawObjects()
 {
-    cv::Mat frame = iVideoProcessor->GetFrameToDisplay();
+    DrawObjects(iVideoProcessor->GetFrameToDisplay());
+}
+
+void TrackerCore::DrawObjects(cv::Mat &aFrame)
+{
+    cv::Mat frame = aFrame;
     cv::Scalar red(0,0,255);
     cv::Scalar green(100,255,100);
 
-    auto draw_single_object = [&frame, &red, &green](MovingObject *aSingle_object)->void
+    auto draw_single_object = [&frame, &red, &green](const ObjectPtr &aSingle_object)->void
     {
         std::string identifier;
         if(!aSingle_object->IsHidden())
@@ -47,23 +143,20 @@ void TrackerCore::DrawObjects()
                 identifier,
                 aSingle_object->getTopLeft(),
                 cv::FONT_HERSHEY_SIMPLEX, 0.5, red, 2);
-        const std::vector<cv::Point> track = aSingle_object->getObjectTrack();
-        if(!track.empty())
+        const TrackHistory &track = aSingle_object->getObjectTrack();
+        for(size_t i=1; i < track.Size(); ++i)
         {
-            for(size_t i=0; i < track.size()-1 ; ++i)
-            {
-                line(frame, track[i], track[i+1], green, 2, 0, 0);
-            }
+            line(frame, track[i-1], track[i], green, 2, 0, 0);
         }
     };
 
-    for(MovingObject* object_iterator : iObjects)
+    for(ObjectPtr& object_iterator : iObjects)
     {
         if(object_iterator->IsSingleObject())
         {
             draw_single_object(object_iterator);
         }else{
-            for(MovingObject* object_inside : object_iterator->GetObjectsInside())
+            for(ObjectPtr& object_inside : object_iterator->GetObjectsInside())
             {
                 if(object_inside->IsSingleObject())
                 {
@@ -76,88 +169,184 @@ void TrackerCore::DrawObjects()
     }
 }
 
-void TrackerCore::InitObjects()
+void TrackerCore::InitObjects(const VideoFrame &aFrame)
 {
-    std::vector<std::vector<cv::Point>> contours;
-    std::vector<cv::Vec4i> hierarchy;
+    OT_PROFILE_SCOPE("blobs");
+    //Only region of interest of the mask is valid, boxes are converted to coordinates of the frame
+    const bool use_roi = aFrame.AnalysisRoi.area() > 0;
 
-    findContours(iVideoProcessor->GetFgMask(), contours, hierarchy, CV_RETR_EXTERNAL, CV_CHAIN_APPROX_SIMPLE, cv::Point(0, 0));
+    //Small blobs are dropped by the extractor, the limit is scaled to pixels of the analysed mask
+    double area_scale = 1.0;
+    if(use_roi && aFrame.Roi.area() > 0)
+        area_scale = double(aFrame.AnalysisRoi.area())/aFrame.Roi.area();
+    iBlobExtractor.SetMinBoxArea(int(iMinObjectArea*area_scale));
 
-    std::vector<std::vector<cv::Point> > contours_poly( contours.size() );
-    std::vector<cv::Rect> rectangle_boundaries(contours.size());
+    const std::vector<Blob> &blobs = iBlobExtractor.Extract(use_roi ? aFrame.FgMask(aFrame.AnalysisRoi) : aFrame.FgMask);
 
-    //Find bounding boxes
-    for(size_t i = 0; i < contours_poly.size(); ++i )
+    ObjectPool &object_pool = iTrackingContext.GetObjectPool();
+
+    for(const Blob &blob : blobs)
     {
-        cv::approxPolyDP( cv::Mat(contours[i]), contours_poly[i], 3, true );
-        rectangle_boundaries[i] = cv::boundingRect( cv::Mat(contours_poly[i]) );
+        cv::Rect box = use_roi ? aFrame.ToFrame(blob.Box) : blob.Box;
+        if(box.area() > iMinObjectArea)
+        {
+            iNewObjects.push_back(object_pool.Create<MovingObject>(box.tl(), box.br(), &iTrackingContext));
+        }
     }
+}
 
-    MovingObject *new_object = nullptr;
+void TrackerCore::BuildObjectGrid()
+{
+    //Grid covers the frame, objects outside the frame are in the border cells
+    iGridColumns = std::max(1, (iHiddenMask.cols + iGridCellSize - 1)/iGridCellSize);
+    iGridRows = std::max(1, (iHiddenMask.rows + iGridCellSize - 1)/iGridCellSize);
 
-    for(cv::Rect& rectangle_iterator : rectangle_boundaries)
+    //Objects in the same order as they were visited by the linear scan
+    iGridCandidates.clear();
+    for(auto& object_iter : iObjects)
     {
-        if(rectangle_iterator.area() > 800)
+        if(object_iter == nullptr)
+            continue;
+        if(object_iter->IsSingleObject())
         {
-            new_object = new MovingObject(rectangle_iterator.tl(), rectangle_iterator.br());
-            iNewObjects.push_back(new_object);
+            iGridCandidates.push_back(GridEntry{&object_iter, iGridCandidates.size(), object_iter->getPredictedCenter()});
+        }else{
+            for(auto& object_inside_iter : object_iter->GetObjectsInside())
+            {
+                if(object_inside_iter != nullptr)
+                    iGridCandidates.push_back(GridEntry{&object_inside_iter, iGridCandidates.size(), object_inside_iter->getPredictedCenter()});
+            }
         }
     }
+
+    //Counting sort by cell keeps the order inside every cell
+    iGridCellStart.assign(size_t(iGridColumns)*iGridRows + 1, 0);
+    iGridEntryCells.resize(iGridCandidates.size());
+    for(size_t i = 0; i < iGridCandidates.size(); ++i)
+    {
+        iGridEntryCells[i] = GridRow(iGridCandidates[i].Center.y)*iGridColumns + GridColumn(iGridCandidates[i].Center.x);
+        ++iGridCellStart[iGridEntryCells[i] + 1];
+    }
+    for(size_t i = 1; i < iGridCellStart.size(); ++i)
+        iGridCellStart[i] += iGridCellStart[i - 1];
+
+    iGridEntries.resize(iGridCandidates.size());
+    std::vector<size_t> &next_entry = iGridCellStart;
+    for(size_t i = 0; i < iGridCandidates.size(); ++i)
+        iGridEntries[next_entry[iGridEntryCells[i]]++] = iGridCandidates[i];
+    //Shift starts back, every start was moved to the start of the next cell
+    for(size_t i = iGridCellStart.size() - 1; i > 0; --i)
+        iGridCellStart[i] = iGridCellStart[i - 1];
+    iGridCellStart[0] = 0;
 }
 
-void TrackerCore::PairObjects()
+void TrackerCore::CollectGridEntries(const cv::Point &aTopLeft, const cv::Point &aBottomRight)
 {
-    for(auto object_iterator : iObjects)
-        object_iterator->PredictPosition();
+    iGridCandidates.clear();
+    for(int row = GridRow(aTopLeft.y); row <= GridRow(aBottomRight.y); ++row)
+    {
+        for(int column = GridColumn(aTopLeft.x); column <= GridColumn(aBottomRight.x); ++column)
+        {
+            const size_t cell = size_t(row)*iGridColumns + column;
+            for(size_t i = iGridCellStart[cell]; i < iGridCellStart[cell + 1]; ++i)
+            {
+                const GridEntry &entry = iGridEntries[i];
+                const cv::Point &Center = entry.Center;
+                //Slot is empty if the object was already paired with another new object
+                if(*entry.Slot != nullptr && aTopLeft.x < Center.x && Center.x < aBottomRight.x &&
+                   aTopLeft.y < Center.y && Center.y < aBottomRight.y)
+                    iGridCandidates.push_back(entry);
+            }
+        }
+    }
+}
+
+void TrackerCore::FindObjectsInside(const MovingObject *aNewObject, std::vector<ObjectPtr> &aObjects)
+{
+    CollectGridEntries(aNewObject->getTopLeft(), aNewObject->getBottomRight());
 
-    float xmin, xmax, ymin, ymax;
-    std::vector<MovingObject *> objects_list;
+    //Objects are paired in the same order as by the linear scan of all objects
+    std::sort(iGridCandidates.begin(), iGridCandidates.end(),
+              [](const GridEntry &aFirst, const GridEntry &aSecond) { return aFirst.Order < aSecond.Order; });
+    for(const GridEntry &entry : iGridCandidates)
+        aObjects.push_back(std::move(*entry.Slot));
+}
 
-    for(MovingObject*& new_object_iter : iNewObjects)
+void TrackerCore::PairObjects()
+{
     {
-        objects_list.clear();
-        xmin = new_object_iter->getTopLeft().x;
-        xmax = new_object_iter->getBottomRight().x;
-        ymin = new_object_iter->getTopLeft().y;
-        ymax = new_object_iter->getBottomRight().y;
+        OT_PROFILE_SCOPE("pairing");
+        for(auto& object_iterator : iObjects)
+            object_iterator->PredictPosition();
+
+        BuildObjectGrid();
 
-        for(auto& object_iter : iObjects)
+        if(iAssociationMode == E_global_association)
         {
-            if(object_iter == nullptr)
-                continue;
-            if(object_iter->IsSingleObject())
+            PairObjectsGlobally();
+        }else{
+            PairObjectsGreedily();
+        }
+    }
+
+    //delete lost objects
+    OT_PROFILE_SCOPE("deletion");
+    size_t length = iObjects.size();
+    for(size_t i=0; i<length; ++i)
+    {
+        if(iObjects[i] != nullptr)
+        {
+            //std::cout << "Deleting object no:" << iObjects[i]->getIdentifier() << std::endl;
+            //delete iObjects[i];
+            if(iObjects[i]->IsSingleObject())
             {
-                const cv::Point Center = object_iter->getPredictedCenter();
-                if(xmin < Center.x && Center.x < xmax && ymin < Center.y && Center.y < ymax)
-                {
-                    objects_list.push_back(object_iter);
-                    object_iter = nullptr;
-                }
-            }else{
-                std::vector<MovingObject *> &objects_inside = object_iter->GetObjectsInside();
-                for(auto& object_inside_iter : objects_inside)
-                {
-                    if(object_inside_iter != nullptr)
-                    {
-                        const cv::Point Center = object_inside_iter->getPredictedCenter();
-                        if(xmin < Center.x && Center.x < xmax && ymin < Center.y && Center.y < ymax)
-                        {
-                            objects_list.push_back(object_inside_iter);
-                            object_inside_iter = nullptr;
-                        }
-                    }
-                } // objects inside
-            } //is single object
-        } // for all objects
+                HandleLostObject(std::move(iObjects[i]));
+            }else{ //single object
+                iObjects[i].reset();
+            }
+        }
+    }
+
+    iObjects.clear();
+    iObjects.swap(iNewObjects);
+
+    iTrackingContext.CorrectAll();
+}
+
+void TrackerCore::HandleLostObject(ObjectPtr aObject)
+{
+    //Object predicted outside the mask has left the scene
+    cv::Point center = aObject->getPredictedCenter();
+    if(cv::Rect(0, 0, iHiddenMask.cols, iHiddenMask.rows).contains(center) && iHiddenMask.at<uchar>(center) > 200)
+    {
+        if(!aObject->IsHidden())
+            aObject->SetAsHidden();
+
+        aObject->NoCorrection();
+
+        if(aObject->GetHiddenCounter() < 60)
+        {
+            iNewObjects.push_back(std::move(aObject));
+        }   //hidden counter, object is deleted otherwise
+    }   //hidden mask
+}
+
+void TrackerCore::PairObjectsGreedily()
+{
+    std::vector<ObjectPtr> objects_list;
+
+    for(ObjectPtr& new_object_iter : iNewObjects)
+    {
+        objects_list.clear();
+        FindObjectsInside(new_object_iter.get(), objects_list);
 
         if(1 == objects_list.size())
         {
             if(objects_list[0]->IsHidden())
                 objects_list[0]->SetAsVisible();
 
-            objects_list[0]->CopyParametersFrom(new_object_iter);
-            delete new_object_iter;
-            new_object_iter = objects_list[0];
+            objects_list[0]->CopyParametersFrom(new_object_iter.get());
+            new_object_iter = std::move(objects_list[0]);
             new_object_iter->CorrectPosition(new_object_iter->getCenter());
         }else if(objects_list.size() > 1){
 
@@ -167,78 +356,91 @@ void TrackerCore::PairObjects()
                 if(objects_list[1]->IsHidden())
                     number_of_hidden_object = 1;
 
-                delete objects_list[1-number_of_hidden_object];
-                delete new_object_iter;
+                objects_list[1-number_of_hidden_object].reset();
 
                 objects_list[number_of_hidden_object]->SetAsVisible();
-                new_object_iter = objects_list[number_of_hidden_object];
+                new_object_iter = std::move(objects_list[number_of_hidden_object]);
                 new_object_iter->CorrectPosition(new_object_iter->getCenter());
 
             }else{
-                MovingMultiObject* new_multiobject = new MovingMultiObject(
+                PoolPtr<MovingMultiObject> new_multiobject = iTrackingContext.GetObjectPool().Create<MovingMultiObject>(
                         new_object_iter->getTopLeft(),
-                        new_object_iter->getBottomRight());
-                for(auto object_iter : objects_list)
+                        new_object_iter->getBottomRight(),
+                        &iTrackingContext);
+                for(auto& object_iter : objects_list)
                 {
-                    new_multiobject->AddNewObject(object_iter);
+                    new_multiobject->AddNewObject(std::move(object_iter));
                 }
                 new_multiobject->NoCorrection();
                 new_multiobject->putTogetherIdentifiers();
-                delete new_object_iter;
-                new_object_iter = new_multiobject;
+                new_object_iter = std::move(new_multiobject);
             }
         }else{
             //new object
         }
 
     } //for all new objects
+}
 
-    //delete lost objects
-    size_t length = iObjects.size();
-    for(size_t i=0; i<length; ++i)
+void TrackerCore::PairObjectsGlobally()
+{
+    //Tracked objects are taken out of multi-objects, every one of them is assigned on its own
+    const size_t track_count = iGridEntries.size();
+    iTracks.resize(track_count);
+    iTrackOccluded.assign(track_count, 0);
+
+    //Gate: predicted center inside the blob expanded by margin, cost is relative squared distance from its center
+    iAssignmentSolver.Reset(track_count, iNewObjects.size());
+    for(size_t blob = 0; blob < iNewObjects.size(); ++blob)
     {
-        if(iObjects[i] != nullptr)
+        const cv::Point top_left = iNewObjects[blob]->getTopLeft();
+        const cv::Point bottom_right = iNewObjects[blob]->getBottomRight();
+        const cv::Point center = iNewObjects[blob]->getCenter();
+        const cv::Point margin(iGateMargin, iGateMargin);
+        const double size = std::max(0.25*(iNewObjects[blob]->getWidth()*iNewObjects[blob]->getWidth() +
+                                           iNewObjects[blob]->getHeight()*iNewObjects[blob]->getHeight()), 1.0);
+
+        CollectGridEntries(top_left - margin, bottom_right + margin);
+        for(const GridEntry &entry : iGridCandidates)
         {
-            //std::cout << "Deleting object no:" << iObjects[i]->getIdentifier() << std::endl;
-            //delete iObjects[i];
-            if(iObjects[i]->IsSingleObject())
-            {
-                cv::Point center = iObjects[i]->getPredictedCenter();
-                if(iHiddenMask.at<uchar>(center) > 200)
-                {
-                    if(!iObjects[i]->IsHidden())
-                        iObjects[i]->SetAsHidden();
-
-                    iObjects[i]->NoCorrection();
-
-                    if(iObjects[i]->GetHiddenCounter() < 60)
-                    {
-                        iNewObjects.push_back(iObjects[i]);
-                    }else{
-                        delete iObjects[i];
-                    }   //hidden counter
-                }else{ //hidden mask
-                    delete iObjects[i];
-                }
-            }else{ //single object
-                delete iObjects[i];
-            }
+            const cv::Point difference = entry.Center - center;
+            iAssignmentSolver.AddEdge(entry.Order, blob, difference.dot(difference)/size);
+            if(top_left.x < entry.Center.x && entry.Center.x < bottom_right.x &&
+               top_left.y < entry.Center.y && entry.Center.y < bottom_right.y)
+                iTrackOccluded[entry.Order] = 1;
         }
     }
+    iAssignmentSolver.Solve(iUnassignedCost, iTrackAssignment);
 
-    iObjects.clear();
-    iObjects = iNewObjects;
-    iNewObjects.clear();
+    //All tracked objects are owned by iTracks now, empty multi-objects are deleted with lost objects
+    for(const GridEntry &entry : iGridEntries)
+        iTracks[entry.Order] = std::move(*entry.Slot);
+
+    for(size_t track = 0; track < track_count; ++track)
+    {
+        ObjectPtr &object = iTracks[track];
+        if(iTrackAssignment[track] >= 0)
+        {
+            ObjectPtr &new_object = iNewObjects[iTrackAssignment[track]];
+            if(object->IsHidden())
+                object->SetAsVisible();
+
+            object->CopyParametersFrom(new_object.get());
+            new_object = std::move(object);
+            new_object->CorrectPosition(new_object->getCenter());
+        }else if(iTrackOccluded[track]){
+            //Object merged with another one into a single blob, it keeps its own track
+            object->NoCorrection();
+            iNewObjects.push_back(std::move(object));
+        }else{
+            HandleLostObject(std::move(object));
+        }
+    }
 }
 
 void TrackerCore::ClearObjects()
 {
-    size_t vector_length = iObjects.size();
-    for(size_t i=0; i<vector_length; ++i)
-    {
-        delete(iObjects.back());
-        iObjects.pop_back();
-    }
+    iObjects.clear();
 }
 
 void TrackerCore::SetVideoProcessor(std::shared_ptr<VideoProcessor> aVideoProcessor)
@@ -261,3 +463,23 @@ void TrackerCore::SetHiddenMask(cv::Mat aMask)
         }
     }
 }
+
+void TrackerCore::SetMap(std::shared_ptr<Map> aMap)
+{
+    iTrackingContext.SetMap(aMap);
+}
+
+void TrackerCore::SetAssociationMode(AssociationMode aMode)
+{
+    iAssociationMode = aMode;
+}
+
+void TrackerCore::SetTrackLength(size_t aLength)
+{
+    iTrackingContext.SetTrackLength(aLength);
+}
+
+void TrackerCore::SetTrackRecorder(std::ostream *aStream)
+{
+    iTrackRecorder = aStream;
+}
@@ -11,25 +11,85 @@
 
 #include <vector>
 #include <memory>
+#include <ostream>
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "VideoProcessor.hpp"
 #include "MovingObject.hpp"
+#include "AssignmentSolver.hpp"
+#include "BlobExtractor.hpp"
+#include "TrackingContext.hpp"
+
+//! Pairing of tracked objects with new objects (blobs)
+enum AssociationMode {
+    E_greedy_association,   ///< Every blob takes all objects predicted inside it, merged objects form a multi-object
+    E_global_association    ///< Objects and blobs are paired by an assignment with minimal total distance
+};
 
 /*!
  * \class TrackerCore
  * \brief Core of tracking algorithm
+ *
+ * New objects (blobs) are paired with tracked objects whose predicted center lies inside the blob. Predicted
+ * centers are put into a uniform grid before pairing, so every blob visits only objects in the grid cells
+ * which its rectangle overlaps.
+ *
+ * In the global association mode (see #E_global_association) each object may be paired with any blob which
+ * contains its predicted center after expanding by a small margin. The pairs are solved together by
+ * AssignmentSolver, so in dense crowds an object is not stolen by the first blob which happens to contain it.
+ * An object which is not paired but lies inside a blob (two objects merged) is kept without correction.
+ *
+ * Kalman filters of all objects are stored in TrackingContext, they are predicted in one pass at the beginning
+ * of every frame and the paired objects are corrected in one pass at the end of pairing. Objects and their
+ * trackers are allocated from pools of the context and owned by ObjectPtr.
+ *
+ * Objects keep only last positions of their tracks for drawing (see TrackHistory). Whole tracks can be written
+ * to a stream set by TrackerCore#SetTrackRecorder.
  */
 class TrackerCore
 {
 private:
-    std::vector<MovingObject *> iNewObjects, iObjects;
+    //! Tracked object in the grid, slot is the place in vector of objects which is cleared when it is paired
+    struct GridEntry
+    {
+        ObjectPtr *Slot;
+        size_t Order;       ///< Order of the object in iObjects (objects inside multi-objects included)
+        cv::Point Center;
+    };
+
+    static const int iGridCellSize = 64;    ///< Size of cell of the grid in pixels
+    static const int iGateMargin = 16;      ///< Expansion of blob in pixels for the global association
+    static constexpr double iUnassignedCost = 1000.0;   ///< Cost of object without blob, higher than any gated pair
+    static const int iMinObjectArea = 800;  ///< Blobs with smaller bounding box (in pixels of the frame) are ignored
+
+    TrackingContext iTrackingContext;
+    std::vector<ObjectPtr> iNewObjects, iObjects;
     std::shared_ptr<VideoProcessor> iVideoProcessor;
-    void InitObjects();
+    std::vector<GridEntry> iGridEntries, iGridCandidates;
+    std::vector<size_t> iGridCellStart;     ///< Entries of cell i are iGridEntries[iGridCellStart[i]..iGridCellStart[i+1])
+    std::vector<int> iGridEntryCells;
+    int iGridColumns, iGridRows;
+    AssociationMode iAssociationMode;
+    AssignmentSolver iAssignmentSolver;
+    BlobExtractor iBlobExtractor;
+    std::vector<ObjectPtr> iTracks;
+    std::vector<int> iTrackAssignment;
+    std::vector<char> iTrackOccluded;
+    std::ostream *iTrackRecorder;
+    void InitObjects(const VideoFrame &aFrame);
     void ClearObjects();
     void PairObjects();
+    void PairObjectsGreedily();
+    void PairObjectsGlobally();
+    void HandleLostObject(ObjectPtr aObject);
+    void RecordTracks(unsigned long aFrameIndex);
+    void BuildObjectGrid();
+    void CollectGridEntries(const cv::Point &aTopLeft, const cv::Point &aBottomRight);
+    void FindObjectsInside(const MovingObject *aNewObject, std::vector<ObjectPtr> &aObjects);
+    int GridColumn(int aX) const { return std::min(std::max(aX/iGridCellSize, 0), iGridColumns - 1); }
+    int GridRow(int aY) const { return std::min(std::max(aY/iGridCellSize, 0), iGridRows - 1); }
     cv::Mat iHiddenMask;
 
 public:
@@ -42,14 +102,45 @@ public:
     /// Find objects tracks from previous frame to this frame
     void TrackObjects();
 
+    /// Find objects tracks from previous frame to the given frame
+    void TrackObjects(const VideoFrame &aFrame);
+
+    /// Track objects detected outside of the tracker, rectangles are in coordinates of the frame
+    void TrackDetections(const std::vector<cv::Rect> &aDetections, unsigned long aFrameIndex = 0);
+
+    /// Return number of tracked objects, multi-object is counted once
+    size_t GetObjectCount() const { return iObjects.size(); }
+
+    /// Move tracked objects by prediction only, for current frame which was not analysed
+    void PredictObjects();
+
+    /// Move tracked objects by prediction only, for the given frame which was not analysed
+    void PredictObjects(const VideoFrame &aFrame);
+
     /// Draw objects to current frame
     void DrawObjects();
 
+    /// Draw objects to the given frame
+    void DrawObjects(cv::Mat &aFrame);
+
     /// Set pointer to video processor
     void SetVideoProcessor(std::shared_ptr<VideoProcessor> aVideoProcessor);
 
     /// Set pointer to mask
     void SetHiddenMask(cv::Mat aMask);
+
+    /// Set velocity map used by map based trackers of objects, it must be called before tracking
+    void SetMap(std::shared_ptr<Map> aMap);
+
+    /// Set pairing of tracked objects with new objects, greedy by default
+    void SetAssociationMode(AssociationMode aMode);
+
+    /// Set number of drawn positions of tracks of new objects
+    void SetTrackLength(size_t aLength);
+
+    /// Write position of every tracked object as line "frame identifier x y" to the stream after every frame,
+    /// nullptr turns recording off (default)
+    void SetTrackRecorder(std::ostream *aStream);
 };
 
 #endif //__TRACKERCORE_HPP__
\ No newline at end of file
@@ -18,7 +18,7 @@
 class TrackerFiles
 {
 private:
-    std::string filePath, videoSuffix, outputVideoSuffix, imageSuffix, mapSuffix, maskSuffix, videoName;
+    std::string filePath, videoSuffix, outputVideoSuffix, imageSuffix, mapSuffix, maskSuffix, roiMaskSuffix, videoName;
 public:
     TrackerFiles(){}
     ~TrackerFiles(){}
@@ -52,6 +52,11 @@ public:
         TrackerFiles::maskSuffix = maskSuffix;
     }
 
+    void setRoiMaskSuffix(const std::string &roiMaskSuffix)
+    {
+        TrackerFiles::roiMaskSuffix = roiMaskSuffix;
+    }
+
     void setVideoName(const std::string &videoName)
     {
         TrackerFiles::videoName = videoName;
@@ -77,11 +82,21 @@ public:
         return filePath+videoName+mapSuffix;
     }
 
+    std::string getTextMapName(void) const
+    {
+        return filePath+videoName+".txt";
+    }
+
     std::string getHiddenMaskName(void) const
     {
         return filePath+videoName+maskSuffix;
     }
 
+    std::string getRoiMaskName(void) const
+    {
+        return filePath+videoName+roiMaskSuffix;
+    }
+
 };
 
 #endif //__TRACKERFILES_H__
@@ -0,0 +1,45 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+
+#include "TrackingContext.hpp"
+#include "MovingObject.hpp"
+#include "BatchedKalmanFilter.hpp"
+#include "FusedTracker.hpp"
+
+TrackingContext::TrackingContext() :
+        iVelocityEngine(
+                KalmanModel<E_constant_velocity>::TimeStep,
+                KalmanModel<E_constant_velocity>::ProcessNoise,
+                KalmanModel<E_constant_velocity>::MeasurementNoise,
+                KalmanModel<E_constant_velocity>::ErrorCovariance),
+        iAccelerationEngine(
+                KalmanModel<E_constant_acceleration>::TimeStep,
+                KalmanModel<E_constant_acceleration>::ProcessNoise,
+                KalmanModel<E_constant_acceleration>::MeasurementNoise,
+                KalmanModel<E_constant_acceleration>::ErrorCovariance),
+        iObjectPool(std::max(sizeof(MovingObject), sizeof(MovingMultiObject))),
+        iTrackerPool(std::max({sizeof(FusedTopology<E_singleKalman_singleMap>::Batched),
+                               sizeof(FusedTopology<E_doubleKalman_singleMap>::Batched),
+                               sizeof(MultipleTracker), sizeof(MapBasedTracker),
+                               sizeof(BatchedKalmanFilter<E_constant_velocity>),
+                               sizeof(BatchedKalmanFilter<E_constant_acceleration>)})),
+        iTrackLength(TrackHistory::iDefaultCapacity)
+{
+
+}
+
+void TrackingContext::PredictAll()
+{
+    iVelocityEngine.PredictAll();
+    iAccelerationEngine.PredictAll();
+}
+
+void TrackingContext::CorrectAll()
+{
+    iVelocityEngine.CorrectAll();
+    iAccelerationEngine.CorrectAll();
+}
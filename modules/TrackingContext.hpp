@@ -0,0 +1,99 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class TrackingContext
+ *
+ */
+
+#ifndef __TRACKINGCONTEXT_HPP__
+#define __TRACKINGCONTEXT_HPP__
+
+#include <memory>
+
+#include "Map.hpp"
+#include "ModifiedKalmanFilter.hpp"
+#include "KalmanEngine.hpp"
+#include "ObjectPool.hpp"
+#include "TrackHistory.hpp"
+
+/*!
+ * \class TrackingContext
+ * \brief State shared by all objects tracked by one TrackerCore
+ *
+ * Context owns Kalman engines of both models. Objects created with the context use BatchedKalmanFilter, whose
+ * state lives in the engines, and they are predicted and corrected together by TrackingContext#PredictAll and
+ * TrackingContext#CorrectAll.
+ *
+ * Context also owns pools of objects (MovingObject, MovingMultiObject) and of their trackers, so blobs which are
+ * created and deleted in every frame reuse the same memory.
+ *
+ * Length of track history of new objects (see TrackHistory) is set by TrackingContext#SetTrackLength.
+ *
+ * Context holds all state of tracking of one video stream, including the velocity map used by MapBasedTracker,
+ * so more streams can be tracked in one process (see MultiStreamTracker).
+ */
+class TrackingContext
+{
+private:
+    KalmanEngine<KalmanModel<E_constant_velocity>::StateSize> iVelocityEngine;
+    KalmanEngine<KalmanModel<E_constant_acceleration>::StateSize> iAccelerationEngine;
+    ObjectPool iObjectPool, iTrackerPool;
+    size_t iTrackLength;
+    std::shared_ptr<Map> iMap;
+
+public:
+    /// Constructor
+    TrackingContext();
+
+    TrackingContext(const TrackingContext &) = delete;
+    TrackingContext &operator=(const TrackingContext &) = delete;
+
+    /// Return engine of the constant velocity model
+    KalmanEngine<KalmanModel<E_constant_velocity>::StateSize> &GetVelocityEngine() { return iVelocityEngine; }
+
+    /// Return engine of the constant acceleration model
+    KalmanEngine<KalmanModel<E_constant_acceleration>::StateSize> &GetAccelerationEngine() { return iAccelerationEngine; }
+
+    /// Return engine of the model given by template argument
+    template<enum KalmanFilterType ModelType>
+    KalmanEngine<KalmanModel<ModelType>::StateSize> &GetEngine();
+
+    /// Return pool for MovingObject and MovingMultiObject
+    ObjectPool &GetObjectPool() { return iObjectPool; }
+
+    /// Return pool for trackers of objects (FusedTracker, MultipleTracker and the trackers inside)
+    ObjectPool &GetTrackerPool() { return iTrackerPool; }
+
+    /// Set number of positions in track history of objects created after this call
+    void SetTrackLength(size_t aLength) { iTrackLength = aLength; }
+
+    /// Return number of positions in track history of new objects
+    size_t GetTrackLength() const { return iTrackLength; }
+
+    /// Set velocity map of the stream, it must be set before any object is created
+    void SetMap(std::shared_ptr<Map> aMap) { iMap = aMap; }
+
+    /// Return velocity map of the stream
+    const Map *GetMap() const { return iMap.get(); }
+
+    /// Predict all tracks, it must be called once per frame before the objects predict their positions
+    void PredictAll();
+
+    /// Correct all tracks which were given a measurement since the last call
+    void CorrectAll();
+};
+
+template<>
+inline KalmanEngine<KalmanModel<E_constant_velocity>::StateSize> &TrackingContext::GetEngine<E_constant_velocity>()
+{
+    return iVelocityEngine;
+}
+
+template<>
+inline KalmanEngine<KalmanModel<E_constant_acceleration>::StateSize> &TrackingContext::GetEngine<E_constant_acceleration>()
+{
+    return iAccelerationEngine;
+}
+
+#endif //__TRACKINGCONTEXT_HPP__
@@ -0,0 +1,61 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of structure VideoFrame
+ *
+ */
+
+#ifndef __VIDEOFRAME_HPP__
+#define __VIDEOFRAME_HPP__
+
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+/*!
+ * \struct VideoFrame
+ * \brief Single frame of video together with all images created during its processing
+ *
+ * Processing of the frame is split into stages (see VideoProcessor#DecodeFrame, VideoProcessor#SubtractBackground,
+ * VideoProcessor#FindFeatures and VideoProcessor#UpdateMap), so the frame can be handed over between threads.
+ *
+ * Buffers are recycled, so they must not be shared with other frames. VideoProcessor#FindFeatures keeps grayscale
+ * image for the next frame and gives back the buffer of previous one, i.e. member Gray is not valid after this stage.
+ *
+ * All stages process only region of interest (see VideoProcessor#OpenRoiMask). Images PreProcessed, Gray and FgMask
+ * may be smaller than Frame (see VideoProcessor#SetAnalysisScale), region Roi of Frame corresponds to region
+ * AnalysisRoi of them. Features and flow are in coordinates of Frame.
+ */
+struct VideoFrame
+{
+    unsigned long Index;                        ///< Order of the frame in video
+    cv::Rect Roi;                               ///< Processed region of Frame
+    cv::Rect AnalysisRoi;                       ///< Processed region of analysis images, they are valid only inside
+    cv::Mat Frame, Analysis, PreProcessed, Gray, FgMask;   ///< Analysis is downscaled Roi of Frame, empty without scaling
+    std::vector<cv::Point2f> FlowFrom, FlowTo;  ///< Good features from previous frame and their position in this frame
+    std::vector<uchar> FlowStatus;              ///< Status of optical flow for every feature
+
+    VideoFrame() : Index(0) {}
+
+    //! Convert point in AnalysisRoi (relative to its corner) to coordinates of Frame
+    cv::Point2f ToFrame(const cv::Point2f &aPoint) const
+    {
+        if(Roi.size() == AnalysisRoi.size())
+            return cv::Point2f(aPoint.x + Roi.x, aPoint.y + Roi.y);
+        return cv::Point2f(Roi.x + aPoint.x*Roi.width/AnalysisRoi.width, Roi.y + aPoint.y*Roi.height/AnalysisRoi.height);
+    }
+
+    //! Convert rectangle in AnalysisRoi (relative to its corner) to coordinates of Frame
+    cv::Rect ToFrame(const cv::Rect &aRect) const
+    {
+        if(Roi.size() == AnalysisRoi.size())
+            return aRect + Roi.tl();
+        cv::Point2f top_left = ToFrame(cv::Point2f((float)aRect.x, (float)aRect.y));
+        cv::Point2f bottom_right = ToFrame(cv::Point2f((float)(aRect.x + aRect.width), (float)(aRect.y + aRect.height)));
+        return cv::Rect(cv::Point(cvRound(top_left.x), cvRound(top_left.y)),
+                        cv::Point(cvRound(bottom_right.x), cvRound(bottom_right.y)));
+    }
+};
+
+#endif //__VIDEOFRAME_HPP__
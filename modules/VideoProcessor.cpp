@@ -5,19 +5,35 @@
 
 #include <iostream>
 #include <complex>
+#include <cmath>
+#include <algorithm>
 
 #include <opencv2/video/tracking.hpp>
 #include "VideoProcessor.hpp"
+#include "Profiler.hpp"
 
-VideoProcessor::VideoProcessor() :
+VideoProcessor::VideoProcessor(bool aDisplayEnabled) :
         iOutputEnabled(false),
         iBgSubtractor(cv::BackgroundSubtractorMOG2(500,60,false)),
+        iAnalysisScale(1.0),
+        iFrameCounter(0),
+        iMapEncoding(E_double_cell),
+        iMapTileSize(0),
+        iMaxFeatures(10),
+        iFirstLoop(true),
         iUseBgImage(false),
+        iUseRoiMask(false),
+        iDisplayEnabled(aDisplayEnabled),
         iDisplayFgMask(false),
-        iDisplayPreProcessedFrame(false)
+        iDisplayPreProcessedFrame(false),
+        iParallelPreProcessing(true)
 {
-    cv::namedWindow("Video", cv::WINDOW_AUTOSIZE);
+    if(iDisplayEnabled)
+        cv::namedWindow("Video", cv::WINDOW_AUTOSIZE);
     iBgSubtractor.set("nmixtures", 5);
+
+    int morph_size = 2;
+    iMorphElement = cv::getStructuringElement( cv::MORPH_ELLIPSE, cv::Size( 2*morph_size + 1, 2*morph_size+1 ), cv::Point( morph_size, morph_size ) );
     //iBgSubtractor.set("fTau", 1);
 }
 
@@ -27,6 +43,7 @@ VideoProcessor::~VideoProcessor()
         iVideoFile.release();
     if(iOutputVideo.isOpened())
         iOutputVideo.release();
+    iMapCheckpointer = nullptr;
     iVelocityMap = nullptr;
 }
 
@@ -39,12 +56,26 @@ bool VideoProcessor::OpenFile(const std::string &aFileName)
         return(false);
     }
 
-    iVideoSize = cv::Size(int(iVideoFile.get(CV_CAP_PROP_FRAME_HEIGHT)), int(iVideoFile.get(CV_CAP_PROP_FRAME_WIDTH)));
+    iVideoSize = cv::Size(int(iVideoFile.get(CV_CAP_PROP_FRAME_WIDTH)), int(iVideoFile.get(CV_CAP_PROP_FRAME_HEIGHT)));
+    iAnalysisSize = iVideoSize;
+    if(iAnalysisScale < 1)
+        iAnalysisSize = cv::Size(std::max(1, cvRound(iVideoSize.width*iAnalysisScale)),
+                                 std::max(1, cvRound(iVideoSize.height*iAnalysisScale)));
+    iRoi = cv::Rect(cv::Point(0, 0), iVideoSize);
+    iUseRoiMask = false;
+    UpdateAnalysisRoi();
 
     unsigned int width = (unsigned int)(iVideoFile.get(CV_CAP_PROP_FRAME_WIDTH));
     unsigned int height = (unsigned int)(iVideoFile.get(CV_CAP_PROP_FRAME_HEIGHT));
     unsigned int grid = 10;
-    iVelocityMap = std::make_shared<Map>(height, width, grid);
+    //All directions of a fixed point cell are read from one cache line
+    const MapLayout layout = (iMapEncoding == E_fixed16_cell) ? E_cell_major : E_direction_major;
+    iVelocityMap = std::make_shared<Map>(height, width, grid, layout, iMapEncoding, iMapTileSize);
+
+    //Preallocate buffers, so no image is allocated while frames are processed
+    FrameBufferPool::AllocateFrame(iFrame, iVideoSize, iAnalysisSize);
+    iPrevFrameGray.create(iAnalysisSize, CV_8U);
+    iFramePool.SetFrameSize(iVideoSize, iAnalysisSize);
 
     return(true);
 }
@@ -86,108 +117,233 @@ cv::Mat VideoProcessor::GetHiddenMask()
     return iHiddenMask;
 }
 
+bool VideoProcessor::OpenRoiMask(const std::string &aFileName)
+{
+    iRoi = cv::Rect(cv::Point(0, 0), iVideoSize);
+    iUseRoiMask = false;
+    UpdateAnalysisRoi();
+
+    cv::Mat mask = cv::imread(aFileName, CV_LOAD_IMAGE_GRAYSCALE);
+    if(mask.empty() || mask.size() != iVideoSize)
+        return(false);
+
+    //JPEG artifacts are removed by threshold
+    cv::threshold(mask, iRoiMask, 127, 255, cv::THRESH_BINARY);
+    std::vector<cv::Point> roi_points;
+    cv::findNonZero(iRoiMask, roi_points);
+    if(roi_points.empty())
+        return(false);
+
+    iRoi = cv::boundingRect(roi_points);
+    //Mask is applied only if it is not the whole rectangle
+    iUseRoiMask = cv::countNonZero(iRoiMask(iRoi)) < iRoi.area();
+    UpdateAnalysisRoi();
+    return(true);
+}
+
+void VideoProcessor::UpdateAnalysisRoi()
+{
+    if(iAnalysisSize == iVideoSize)
+    {
+        iAnalysisRoi = iRoi;
+        if(iUseRoiMask)
+            iAnalysisRoiMask = iRoiMask(iRoi);
+        return;
+    }
+
+    //Region is rounded outwards, frame region is resized to exactly this size
+    const int left = (int)std::floor(iRoi.x*iAnalysisScale);
+    const int top = (int)std::floor(iRoi.y*iAnalysisScale);
+    const int right = std::min((int)std::ceil((iRoi.x + iRoi.width)*iAnalysisScale), iAnalysisSize.width);
+    const int bottom = std::min((int)std::ceil((iRoi.y + iRoi.height)*iAnalysisScale), iAnalysisSize.height);
+    iAnalysisRoi = cv::Rect(left, top, std::max(1, right - left), std::max(1, bottom - top));
+    if(iUseRoiMask)
+        cv::resize(iRoiMask(iRoi), iAnalysisRoiMask, iAnalysisRoi.size(), 0, 0, cv::INTER_NEAREST);
+    iFrame.Analysis.create(iAnalysisRoi.size(), CV_8UC3);
+}
+
+cv::Mat VideoProcessor::AnalysisView(const cv::Mat &aSource, cv::Mat &aBuffer) const
+{
+    if(iAnalysisSize == iVideoSize)
+        return aSource(iRoi);
+
+    //Buffer holds only the region, so the blur reflects its border instead of reading uninitialized pixels around it
+    aBuffer.create(iAnalysisRoi.size(), aSource.type());
+    cv::resize(aSource(iRoi), aBuffer, iAnalysisRoi.size(), 0, 0, cv::INTER_AREA);
+    return aBuffer;
+}
+
 void VideoProcessor::DisplayOutput()
 {
-    cv::imshow("Video", iActFrame);
-    if(iDisplayFgMask)
-        cv::imshow("fgMask", iFgMask);
-    if(iDisplayPreProcessedFrame)
-        cv::imshow("preProcFrame", iPreProcessedFrame);
+    DisplayOutput(iFrame);
+}
+
+void VideoProcessor::DisplayOutput(const VideoFrame &aFrame)
+{
+    if(iDisplayEnabled)
+    {
+        cv::imshow("Video", aFrame.Frame);
+        if(iDisplayFgMask)
+            cv::imshow("fgMask", aFrame.FgMask);
+        if(iDisplayPreProcessedFrame)
+            cv::imshow("preProcFrame", aFrame.PreProcessed);
+    }
     if(iOutputEnabled)
     {
-        iOutputVideo << iActFrame;
+        iOutputVideo << aFrame.Frame;
     }
 }
 
-void VideoProcessor::PreProcessFrame()
+bool VideoProcessor::ReadNextFrame()
 {
-    cv::GaussianBlur(iActFrame, iPreProcessedFrame, cv::Size(5,5), 2);
-    iPreProcessedFrame.convertTo(iPreProcessedFrame, -1, 1.1, 0);
+    if(!DecodeFrame(iFrame))
+        return(false);
+
+    SubtractBackground(iFrame);
+    FindFeatures(iFrame);
+    UpdateMap(iFrame);
+
+    return(true);
 }
 
-bool VideoProcessor::ReadNextFrame() {
+bool VideoProcessor::SkipFrame()
+{
+    if(!DecodeFrame(iFrame))
+        return(false);
 
-    static bool firstLoop = true;
+    iGoodFeatures.clear();
+    iFrame.FlowFrom.clear();
+    iFrame.FlowTo.clear();
+    iFrame.FlowStatus.clear();
+    return(true);
+}
 
-    iVideoFile >> iActFrame;
-    if(iActFrame.empty())
+bool VideoProcessor::DecodeFrame(VideoFrame &aFrame)
+{
+    OT_PROFILE_SCOPE("decode");
+    iVideoFile >> aFrame.Frame;
+    if(aFrame.Frame.empty())
         return(false);
 
-    //Initialize background image
-    if(firstLoop)
+    //Initialize background model. This is done before any frame is passed to the other stages.
+    if(iFirstLoop)
     {
         double bg_coef = 0.01;
+        cv::Mat pre_processed = aFrame.PreProcessed(iAnalysisRoi), fg_mask = aFrame.FgMask(iAnalysisRoi);
         if(iUseBgImage)
         {
-            iActFrame = iBgImage;
-            PreProcessFrame();
-            iBgSubtractor(iPreProcessedFrame, iFgMask, bg_coef);
+            FramePreProcessor::Process(AnalysisView(iBgImage, aFrame.Analysis), pre_processed, nullptr,
+                                       iParallelPreProcessing);
+            iBgSubtractor(pre_processed, fg_mask, bg_coef);
         }
         for (int i = 0; i < 20; ++i) {
-            iVideoFile >> iActFrame;
-            if(iActFrame.empty())
+            iVideoFile >> aFrame.Frame;
+            if(aFrame.Frame.empty())
                 return(false);
-            PreProcessFrame();
-            iBgSubtractor(iPreProcessedFrame, iFgMask, bg_coef);
+            FramePreProcessor::Process(AnalysisView(aFrame.Frame, aFrame.Analysis), pre_processed, nullptr,
+                                       iParallelPreProcessing);
+            iBgSubtractor(pre_processed, fg_mask, bg_coef);
         }
+        iFirstLoop = false;
     }
 
+    aFrame.Index = iFrameCounter++;
+    aFrame.Roi = iRoi;
+    aFrame.AnalysisRoi = iAnalysisRoi;
 
-    //Pre-processing
-    PreProcessFrame();
-    cv::cvtColor(iActFrame, iActFrameGray, cv::COLOR_RGB2GRAY, CV_8U);
+    return(true);
+}
+
+void VideoProcessor::SubtractBackground(VideoFrame &aFrame)
+{
+    //Images are views of region of interest, results are written directly to buffers of the frame
+    cv::Mat frame = AnalysisView(aFrame.Frame, aFrame.Analysis);
+    cv::Mat pre_processed = aFrame.PreProcessed(aFrame.AnalysisRoi);
+    cv::Mat gray = aFrame.Gray(aFrame.AnalysisRoi), fg_mask = aFrame.FgMask(aFrame.AnalysisRoi);
+
+    //Pre-processing and conversion to gray in one pass
+    {
+        OT_PROFILE_SCOPE("preprocess");
+        FramePreProcessor::Process(frame, pre_processed, &gray, iParallelPreProcessing);
+    }
 
     //Background  subtraction
-    iBgSubtractor(iPreProcessedFrame, iFgMask, 5e-4);
+    {
+        OT_PROFILE_SCOPE("mog2");
+        iBgSubtractor(pre_processed, fg_mask, 5e-4);
+    }
 
     //Mathematical morphology
-    int morph_size = 2;
-    cv::Mat element = getStructuringElement( cv::MORPH_ELLIPSE, cv::Size( 2*morph_size + 1, 2*morph_size+1 ), cv::Point( morph_size, morph_size ) );
-    cv::morphologyEx(iFgMask, iFgMask, cv::MORPH_CLOSE, element);
+    OT_PROFILE_SCOPE("morphology");
+    cv::morphologyEx(fg_mask, fg_mask, cv::MORPH_CLOSE, iMorphElement);
+
+    if(iUseRoiMask)
+        cv::bitwise_and(fg_mask, iAnalysisRoiMask, fg_mask);
+}
+
+void VideoProcessor::FindFeatures(VideoFrame &aFrame)
+{
+    aFrame.FlowFrom.clear();
+    aFrame.FlowTo.clear();
+    aFrame.FlowStatus.clear();
+
+    //Features are found in region of interest of analysis images, iGoodFeatures are in its coordinates
+    cv::Mat gray = aFrame.Gray(aFrame.AnalysisRoi);
 
-    if(!firstLoop && !iGoodFeatures.empty())
+    if(!iGoodFeatures.empty())
     {
-        std::vector<uchar> status;
-        std::vector<float> err;
-        std::vector<cv::Point2f> features_next;
-        cv::calcOpticalFlowPyrLK(iPrevFrameGray, iActFrameGray, iGoodFeatures, features_next, status, err);
-        for(size_t i=0; i<iGoodFeatures.size(); ++i)
+        OT_PROFILE_SCOPE("optical flow");
+        cv::calcOpticalFlowPyrLK(iPrevFrameGray(aFrame.AnalysisRoi), gray, iGoodFeatures, aFrame.FlowTo, aFrame.FlowStatus, iFlowError);
+        //Features are moved to the frame, vector of the frame is reused for the new features
+        std::swap(aFrame.FlowFrom, iGoodFeatures);
+
+        if(aFrame.Roi != cv::Rect(cv::Point(0, 0), aFrame.AnalysisRoi.size()))
         {
-            double angle = Map::CalcAngle((features_next[i].y - iGoodFeatures[i].y), (features_next[i].x - iGoodFeatures[i].x));
-            if(iVelocityMap != nullptr)
-                iVelocityMap->SetVelocityVector(
-                        (unsigned int)(iGoodFeatures[i].x),
-                        (unsigned int)(iGoodFeatures[i].y),
-                        features_next[i].x - iGoodFeatures[i].x,
-                        features_next[i].y - iGoodFeatures[i].y,
-                        angle);
+            for(cv::Point2f &point : aFrame.FlowFrom)
+                point = aFrame.ToFrame(point);
+            for(cv::Point2f &point : aFrame.FlowTo)
+                point = aFrame.ToFrame(point);
         }
     }
 
     //Find good features to track
+    OT_PROFILE_SCOPE("corners");
     //Detector's parameters
-    int maxCorners = 10;
+    int maxCorners = iMaxFeatures;
     double qualityLevel = 0.01;
     double minDistance = 5.0;
     int blockSize = 3;
     bool useHarrisDetector = false;
     double k = 0.04;
-    cv::goodFeaturesToTrack( iActFrameGray, iGoodFeatures, maxCorners, qualityLevel, minDistance, iFgMask, blockSize, useHarrisDetector, k );
+    cv::goodFeaturesToTrack( gray, iGoodFeatures, maxCorners, qualityLevel, minDistance, aFrame.FgMask(aFrame.AnalysisRoi), blockSize, useHarrisDetector, k );
 
-    iPrevFrameGray = iActFrameGray.clone();
-    firstLoop = false;
+    //Double buffering: keep grayscale image for the next frame and recycle the previous one
+    cv::swap(iPrevFrameGray, aFrame.Gray);
+}
 
-    return(true);
+void VideoProcessor::UpdateMap(const VideoFrame &aFrame)
+{
+    if(iVelocityMap == nullptr)
+        return;
+
+    OT_PROFILE_SCOPE("map update");
+    OT_PROFILE_COUNTER("map updates", std::count(aFrame.FlowStatus.begin(), aFrame.FlowStatus.end(), 1));
+
+    //Features which were not found in the new frame are skipped
+    iVelocityMap->SetVelocityVectors(aFrame.FlowFrom, aFrame.FlowTo, aFrame.FlowStatus);
+
+    if(iMapCheckpointer != nullptr)
+        iMapCheckpointer->Poll();
 }
 
 const cv::Mat& VideoProcessor::GetFgMask()
 {
-    return iFgMask;
+    return iFrame.FgMask;
 }
 
 cv::Mat& VideoProcessor::GetFrameToDisplay()
 {
-    return iActFrame;
+    return iFrame.Frame;
 }
 
 
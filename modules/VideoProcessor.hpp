@@ -17,6 +17,9 @@
 #include <opencv2/imgproc/imgproc.hpp>
 
 #include "Map.hpp"
+#include "FrameBufferPool.hpp"
+#include "FramePreProcessor.hpp"
+#include "MapCheckpointer.hpp"
 
 /*!
  * \class VideoProcessor
@@ -25,6 +28,17 @@
  * Class provide an interface for setting the video file name, the background image file name, reading next frame
  * and displaying frames. When the method for opening the video file is called also an instance of map is created.
  * Map is filled with data every time the VideoProcessor#ReadNextFrame method is called.
+ *
+ * VideoProcessor#ReadNextFrame runs all processing stages in sequence. The stages can be also called separately
+ * (each of them from one thread only and with frames in order), which is used by FramePipeline.
+ *
+ * If a mask of region of interest is opened, all stages after decoding process only the bounding rectangle of
+ * the mask and motion outside the mask is removed from the foreground mask. Features and optical flow are
+ * translated to coordinates of the whole frame.
+ *
+ * With analysis scale below one (see VideoProcessor#SetAnalysisScale) the region is downscaled before
+ * pre-processing and all vision stages run on the smaller images. Flow is scaled back, so the map, objects
+ * and drawing stay in coordinates of the source video.
  */
 class VideoProcessor
 {
@@ -32,19 +46,31 @@ private:
     cv::VideoCapture iVideoFile;
     bool iOutputEnabled;
     cv::VideoWriter iOutputVideo;
-    cv::Mat iActFrame, iActFrameGray, iPrevFrameGray, iPreProcessedFrame, iFgMask, iBgImage, iHiddenMask;
+    VideoFrame iFrame;
+    FrameBufferPool iFramePool;
+    cv::Mat iPrevFrameGray, iBgImage, iHiddenMask, iRoiMask, iAnalysisRoiMask, iMorphElement;
+    cv::Rect iRoi, iAnalysisRoi;
     cv::BackgroundSubtractorMOG2 iBgSubtractor;
-    cv::Size iVideoSize;
+    cv::Size iVideoSize, iAnalysisSize;
+    double iAnalysisScale;
+    unsigned long iFrameCounter;
 
     std::vector<cv::Point2f> iGoodFeatures;
+    std::vector<float> iFlowError;
     std::shared_ptr<Map> iVelocityMap;
-    bool iUseBgImage, iDisplayFgMask, iDisplayPreProcessedFrame;
+    std::shared_ptr<MapCheckpointer> iMapCheckpointer;
+    MapCellEncoding iMapEncoding;
+    unsigned int iMapTileSize;
+    int iMaxFeatures;
+    bool iFirstLoop, iUseBgImage, iUseRoiMask, iDisplayEnabled, iDisplayFgMask, iDisplayPreProcessedFrame;
+    bool iParallelPreProcessing;
 
-    void PreProcessFrame();
+    void UpdateAnalysisRoi();
+    cv::Mat AnalysisView(const cv::Mat &aSource, cv::Mat &aBuffer) const;
 
 public:
-    //! Constructor
-    VideoProcessor();
+    //! Constructor, no HighGUI window is opened when aDisplayEnabled is false (headless mode)
+    explicit VideoProcessor(bool aDisplayEnabled = true);
 
     //! Destructor
     ~VideoProcessor();
@@ -52,6 +78,24 @@ public:
     //! Open video file
     bool OpenFile(const std::string &aFileName);
 
+    //! Set encoding of cells of map created by VideoProcessor#OpenFile
+    void SetMapEncoding(MapCellEncoding aEncoding) { iMapEncoding = aEncoding; }
+
+    //! Set size of tiles of sparse map created by VideoProcessor#OpenFile, 0 creates dense map
+    void SetMapTileSize(unsigned int aTileSize) { iMapTileSize = aTileSize; }
+
+    //! Set scale of images analysed by vision stages (0 to 1, 1 by default), it must be called before VideoProcessor#OpenFile
+    void SetAnalysisScale(double aScale) { iAnalysisScale = (aScale > 0 && aScale < 1) ? aScale : 1.0; }
+
+    //! Set maximal number of features tracked by optical flow, their velocity vectors are added to the map
+    void SetMaxFeatures(int aMaxFeatures) { iMaxFeatures = aMaxFeatures; }
+
+    //! Set whether pre-processing of a frame runs in parallel (default), turned off when frames are processed by a pool
+    void SetParallelPreProcessing(bool aParallel) { iParallelPreProcessing = aParallel; }
+
+    //! Set checkpointer which is polled after every update of the map
+    void SetMapCheckpointer(std::shared_ptr<MapCheckpointer> aCheckpointer) { iMapCheckpointer = aCheckpointer; }
+
     //! Set output video file name
     bool SetOutputFile(const std::string &aFileName);
 
@@ -64,15 +108,64 @@ public:
     //! Return hidden mask
     cv::Mat GetHiddenMask();
 
+    /*!
+     * \brief Open mask of region of interest, nonzero pixels are processed
+     *
+     * It must be called after VideoProcessor#OpenFile and before the first frame. Return false if the mask cannot
+     * be opened, its size differs from the video or it is empty, whole frame is processed in that case.
+     */
+    bool OpenRoiMask(const std::string &aFileName);
+
+    //! Return processed region of frame, whole frame if there is no mask of region of interest
+    cv::Rect GetRoi() const { return iRoi; }
+
     //! Return size of video
     cv::Size GetVideoSize() { return iVideoSize; }
 
-    //! Display video frames
+    //! Return frame rate of video, 0 if it is unknown
+    double GetFrameRate() { return iVideoFile.get(CV_CAP_PROP_FPS); }
+
+    //! Return true if frames are shown in HighGUI windows
+    bool IsDisplayEnabled() const { return iDisplayEnabled; }
+
+    //! Return true if frames are written to the output video file
+    bool IsOutputEnabled() const { return iOutputEnabled; }
+
+    //! Display video frames and write them to the output file
     void DisplayOutput();
 
+    //! Display given frame and write it to the output file
+    void DisplayOutput(const VideoFrame &aFrame);
+
     //! Read next frame from video file and process it
     bool ReadNextFrame();
 
+    /*!
+     * \brief Read next frame from video file without any analysis
+     *
+     * Frame is only available for drawing. Features are detected again in the next analysed frame, flow across
+     * the skipped frames is not put into the map.
+     */
+    bool SkipFrame();
+
+    //! Stage 1: read next frame from video file, background model is initialized before the first frame
+    bool DecodeFrame(VideoFrame &aFrame);
+
+    //! Stage 2: pre-processing, conversion to grayscale, background subtraction and morphology
+    void SubtractBackground(VideoFrame &aFrame);
+
+    //! Stage 3: optical flow of good features from previous frame and detection of new good features
+    void FindFeatures(VideoFrame &aFrame);
+
+    //! Stage 4: fill map with optical flow found in the frame
+    void UpdateMap(const VideoFrame &aFrame);
+
+    //! Return frame processed by the last call of VideoProcessor#ReadNextFrame
+    const VideoFrame &GetCurrentFrame() const { return iFrame; }
+
+    //! Return pool of frames with buffers allocated for size of opened video
+    FrameBufferPool &GetFramePool() { return iFramePool; }
+
     //! Return foreground mask. This method is called from TrackerCore class
     const cv::Mat &GetFgMask();
 
@@ -88,15 +181,17 @@ public:
     //! Turn on displaying of foreground mask
     void DisplayFgMask()
     {
-        iDisplayFgMask = true;
-        cv::namedWindow("fgMask", cv::WINDOW_AUTOSIZE);
+        iDisplayFgMask = iDisplayEnabled;
+        if(iDisplayEnabled)
+            cv::namedWindow("fgMask", cv::WINDOW_AUTOSIZE);
     }
 
     //! Turn on displaying of preprocessed frame
     void DisplayPreProcess()
     {
-        iDisplayPreProcessedFrame = true;
-        cv::namedWindow("preProcFrame", cv::WINDOW_AUTOSIZE);
+        iDisplayPreProcessedFrame = iDisplayEnabled;
+        if(iDisplayEnabled)
+            cv::namedWindow("preProcFrame", cv::WINDOW_AUTOSIZE);
     }
 };
 
@@ -0,0 +1,121 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ */
+
+#include <algorithm>
+
+#include "WorkStealingPool.hpp"
+
+namespace
+{
+    //! Pool and queue of the worker running in this thread
+    thread_local const WorkStealingPool *tCurrentPool = nullptr;
+    thread_local size_t tCurrentQueue = 0;
+}
+
+WorkStealingPool::WorkStealingPool(unsigned int aThreadCount) :
+        iNextQueue(0),
+        iPendingTasks(0),
+        iStop(false)
+{
+    if(aThreadCount == 0)
+        aThreadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for(unsigned int i = 0; i < aThreadCount; ++i)
+        iQueues.emplace_back(new WorkerQueue());
+    for(unsigned int i = 0; i < aThreadCount; ++i)
+        iThreads.emplace_back(&WorkStealingPool::RunWorker, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(iSleepMutex);
+        iStop = true;
+    }
+    iWakeUp.notify_all();
+    for(std::thread &thread : iThreads)
+        thread.join();
+}
+
+void WorkStealingPool::Submit(std::function<void()> aTask)
+{
+    size_t index;
+    if(tCurrentPool == this)
+        index = tCurrentQueue;
+    else
+        index = iNextQueue.fetch_add(1) % iQueues.size();
+
+    //Counter is increased first, so it is never lower than the number of tasks in queues
+    {
+        std::lock_guard<std::mutex> lock(iSleepMutex);
+        ++iPendingTasks;
+    }
+    {
+        std::lock_guard<std::mutex> lock(iQueues[index]->Mutex);
+        iQueues[index]->Tasks.push_back(std::move(aTask));
+    }
+    iWakeUp.notify_one();
+}
+
+bool WorkStealingPool::TakeTask(size_t aIndex, std::function<void()> &aTask)
+{
+    //Own queue first, then the other queues starting with the next one
+    for(size_t i = 0; i < iQueues.size(); ++i)
+    {
+        WorkerQueue &queue = *iQueues[(aIndex + i) % iQueues.size()];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if(!queue.Tasks.empty())
+        {
+            aTask = std::move(queue.Tasks.front());
+            queue.Tasks.pop_front();
+            return(true);
+        }
+    }
+    return(false);
+}
+
+void WorkStealingPool::RunWorker(size_t aIndex)
+{
+    tCurrentPool = this;
+    tCurrentQueue = aIndex;
+
+    std::function<void()> task;
+    while(true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(iSleepMutex);
+            iWakeUp.wait(lock, [this]{ return iStop || iPendingTasks > 0; });
+            if(iStop)
+                break;
+        }
+
+        if(!TakeTask(aIndex, task))
+            continue;   //Task was taken by another worker or it is being submitted
+
+        {
+            std::lock_guard<std::mutex> lock(iSleepMutex);
+            --iPendingTasks;
+        }
+
+        try
+        {
+            task();
+        }catch(...){
+            std::lock_guard<std::mutex> lock(iErrorMutex);
+            if(!iError)
+                iError = std::current_exception();
+        }
+        task = nullptr;
+    }
+
+    tCurrentPool = nullptr;
+}
+
+void WorkStealingPool::RethrowError()
+{
+    std::lock_guard<std::mutex> lock(iErrorMutex);
+    if(iError)
+        std::rethrow_exception(iError);
+}
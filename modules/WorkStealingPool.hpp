@@ -0,0 +1,77 @@
+/*!
+ * \file
+ * \author Martin Sehnoutka
+ *
+ * \brief Declaration of class WorkStealingPool
+ *
+ */
+
+#ifndef __WORKSTEALINGPOOL_HPP__
+#define __WORKSTEALINGPOOL_HPP__
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+/*!
+ * \class WorkStealingPool
+ * \brief Fixed number of worker threads with own queues of tasks
+ *
+ * Task submitted from a worker goes to the queue of this worker, other tasks are distributed to the queues
+ * in round robin. Worker takes tasks from the front of its queue, so a task which submits its continuation
+ * gets its next turn after all tasks which were waiting before. When its queue is empty, the worker steals
+ * a task from the front of queue of another worker and sleeps only if all queues are empty.
+ *
+ * First exception thrown by a task is kept and rethrown by WorkStealingPool#RethrowError.
+ */
+class WorkStealingPool
+{
+private:
+    struct WorkerQueue
+    {
+        std::mutex Mutex;
+        std::deque<std::function<void()>> Tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> iQueues;
+    std::vector<std::thread> iThreads;
+    std::atomic<size_t> iNextQueue;
+
+    std::mutex iSleepMutex;
+    std::condition_variable iWakeUp;
+    size_t iPendingTasks;   ///< Tasks in all queues, guarded by iSleepMutex
+    bool iStop;
+
+    std::mutex iErrorMutex;
+    std::exception_ptr iError;
+
+    void RunWorker(size_t aIndex);
+    bool TakeTask(size_t aIndex, std::function<void()> &aTask);
+
+public:
+    //! Constructor starts the threads, number of threads is taken from the hardware if aThreadCount is 0
+    explicit WorkStealingPool(unsigned int aThreadCount = 0);
+
+    //! Destructor waits for the running tasks, tasks in queues are dropped
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    //! Add task to a queue, it may be called from any thread including the workers
+    void Submit(std::function<void()> aTask);
+
+    //! Rethrow the first exception thrown by a task, if any
+    void RethrowError();
+
+    //! Return number of worker threads
+    size_t GetThreadCount() const { return iThreads.size(); }
+};
+
+#endif //__WORKSTEALINGPOOL_HPP__
@@ -0,0 +1,190 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cmath>
+#include "../modules/KalmanEngine.hpp"
+#include "../modules/FixedKalmanFilter.hpp"
+#include "../modules/ModifiedKalmanFilter.hpp"
+
+/*
+ * Compares batched KalmanEngine with FixedKalmanFilter and FixedKalmanFilter with a general Kalman filter in
+ * double precision. Random tracks move along lines with noisy measurements, some frames have no measurement
+ * and tracks are removed and added, so slots are reused. KalmanEngine must give exactly the same states as
+ * FixedKalmanFilter, centers of FixedKalmanFilter must stay within 1 px of the double precision filter.
+ * Exact equality holds only if the compiler does not contract operations to FMA (-ffp-contract=off is needed
+ * with -march supporting FMA).
+ */
+namespace
+{
+    //! Kalman filter of the same model with general matrix operations in double precision
+    template<int StateSize>
+    class ReferenceFilter
+    {
+    private:
+        double iTransition[StateSize][StateSize], iErrorCov[StateSize][StateSize];
+        double iProcessNoise, iMeasurementNoise;
+
+    public:
+        double State[StateSize];
+
+        ReferenceFilter(double aTimeStep, double aProcessNoise, double aMeasurementNoise, double aErrorCovariance) :
+                iProcessNoise(aProcessNoise),
+                iMeasurementNoise(aMeasurementNoise)
+        {
+            for(int i = 0; i < StateSize; ++i)
+            {
+                State[i] = 0;
+                for(int j = 0; j < StateSize; ++j)
+                {
+                    iTransition[i][j] = (i == j) ? 1.0 : (j == i + 2 ? aTimeStep : 0.0);
+                    iErrorCov[i][j] = (i == j) ? aErrorCovariance : 0.0;
+                }
+            }
+        }
+
+        void Predict()
+        {
+            double state[StateSize] = {0}, product[StateSize][StateSize] = {{0}};
+            for(int i = 0; i < StateSize; ++i)
+                for(int k = 0; k < StateSize; ++k)
+                    state[i] += iTransition[i][k]*State[k];
+            for(int i = 0; i < StateSize; ++i)
+                for(int j = 0; j < StateSize; ++j)
+                    for(int k = 0; k < StateSize; ++k)
+                        product[i][j] += iTransition[i][k]*iErrorCov[k][j];
+            for(int i = 0; i < StateSize; ++i)
+            {
+                State[i] = state[i];
+                for(int j = 0; j < StateSize; ++j)
+                {
+                    iErrorCov[i][j] = (i == j) ? iProcessNoise : 0.0;
+                    for(int k = 0; k < StateSize; ++k)
+                        iErrorCov[i][j] += product[i][k]*iTransition[j][k];
+                }
+            }
+        }
+
+        void Correct(double aX, double aY)
+        {
+            const double s00 = iErrorCov[0][0] + iMeasurementNoise, s01 = iErrorCov[0][1];
+            const double s10 = iErrorCov[1][0], s11 = iErrorCov[1][1] + iMeasurementNoise;
+            const double determinant = s00*s11 - s01*s10;
+            double gain[StateSize][2], covariance[StateSize][StateSize];
+            for(int i = 0; i < StateSize; ++i)
+            {
+                gain[i][0] = (iErrorCov[i][0]*s11 - iErrorCov[i][1]*s10)/determinant;
+                gain[i][1] = (iErrorCov[i][1]*s00 - iErrorCov[i][0]*s01)/determinant;
+            }
+            const double residual_x = aX - State[0], residual_y = aY - State[1];
+            for(int i = 0; i < StateSize; ++i)
+            {
+                State[i] += gain[i][0]*residual_x + gain[i][1]*residual_y;
+                for(int j = 0; j < StateSize; ++j)
+                    covariance[i][j] = iErrorCov[i][j] - (gain[i][0]*iErrorCov[0][j] + gain[i][1]*iErrorCov[1][j]);
+            }
+            std::copy(&covariance[0][0], &covariance[0][0] + StateSize*StateSize, &iErrorCov[0][0]);
+        }
+    };
+
+    //! Track driven by all three filters
+    template<int StateSize>
+    struct Track
+    {
+        size_t Slot;
+        FixedKalmanFilter<StateSize> Fixed;
+        ReferenceFilter<StateSize> Reference;
+        double X, Y, VelocityX, VelocityY;
+    };
+
+    template<enum KalmanFilterType ModelType>
+    bool CompareFilters(const char *aName)
+    {
+        typedef KalmanModel<ModelType> Model;
+        const int state_size = Model::StateSize;
+        const int frames = 300, max_tracks = 64;
+
+        KalmanEngine<state_size> engine(Model::TimeStep, Model::ProcessNoise, Model::MeasurementNoise,
+                                        Model::ErrorCovariance);
+        std::vector<Track<state_size>> tracks;
+        std::mt19937 generator(7);
+        std::uniform_real_distribution<double> position(0.0, 1000.0), velocity(-3.0, 3.0), chance(0.0, 1.0);
+        std::normal_distribution<double> noise(0.0, 2.0);
+
+        unsigned long mismatches = 0;
+        double max_error = 0;
+        for(int frame = 0; frame < frames; ++frame)
+        {
+            //Tracks are removed and added, so the engine reuses free slots
+            for(size_t i = 0; i < tracks.size(); )
+            {
+                if(chance(generator) < 0.01)
+                {
+                    engine.RemoveTrack(tracks[i].Slot);
+                    tracks.erase(tracks.begin() + i);
+                }else{
+                    ++i;
+                }
+            }
+            while(tracks.size() < size_t(max_tracks) && chance(generator) < 0.5)
+            {
+                Track<state_size> track{engine.AddTrack(),
+                        FixedKalmanFilter<state_size>(Model::TimeStep, Model::ProcessNoise, Model::MeasurementNoise,
+                                                      Model::ErrorCovariance),
+                        ReferenceFilter<state_size>(Model::TimeStep, Model::ProcessNoise, Model::MeasurementNoise,
+                                                    Model::ErrorCovariance),
+                        position(generator), position(generator), velocity(generator), velocity(generator)};
+                engine.SetPosition(track.Slot, float(track.X), float(track.Y));
+                track.Fixed.SetPosition(float(track.X), float(track.Y));
+                track.Reference.State[0] = float(track.X);
+                track.Reference.State[1] = float(track.Y);
+                tracks.push_back(track);
+            }
+
+            engine.PredictAll();
+            for(Track<state_size> &track : tracks)
+            {
+                track.Fixed.Predict();
+                track.Reference.Predict();
+                track.X += track.VelocityX;
+                track.Y += track.VelocityY;
+            }
+
+            //Frames without any measurement are included
+            const double measured_fraction = (frame % 10 == 9) ? 0.0 : 0.8;
+            for(Track<state_size> &track : tracks)
+            {
+                if(chance(generator) >= measured_fraction)
+                    continue;
+                const float x = float(track.X + noise(generator)), y = float(track.Y + noise(generator));
+                engine.SetMeasurement(track.Slot, x, y);
+                track.Fixed.Correct(x, y);
+                track.Reference.Correct(x, y);
+            }
+            engine.CorrectAll();
+
+            for(const Track<state_size> &track : tracks)
+            {
+                for(int i = 0; i < state_size; ++i)
+                {
+                    if(engine.GetStatePre(track.Slot, i) != track.Fixed.GetStatePre()(i) ||
+                            engine.GetStatePost(track.Slot, i) != track.Fixed.GetStatePost()(i))
+                        ++mismatches;
+                }
+                max_error = std::max(max_error, std::hypot(track.Fixed.GetStatePost()(0) - track.Reference.State[0],
+                                                           track.Fixed.GetStatePost()(1) - track.Reference.State[1]));
+            }
+        }
+
+        std::cout << aName << ": engine mismatches " << mismatches << ", max error against double filter "
+                  << max_error << " px" << std::endl;
+        return(mismatches == 0 && max_error < 1.0);
+    }
+}
+
+int main(void)
+{
+    const bool velocity_passed = CompareFilters<E_constant_velocity>("constant velocity");
+    const bool acceleration_passed = CompareFilters<E_constant_acceleration>("constant acceleration");
+    return(velocity_passed && acceleration_passed ? 0 : 1);
+}
@@ -0,0 +1,63 @@
+#include <iostream>
+#include <random>
+#include <complex>
+#include <algorithm>
+#include "../modules/Map.hpp"
+
+/*
+ * Measures error of velocity vectors stored in compact map cells against the map with double cells.
+ * The same random velocity vectors are written to maps with all encodings and the velocity of every
+ * cell is compared. Test fails if errors exceed the bounds documented in Map.hpp (MapCellEncoding).
+ */
+int main(void)
+{
+    const unsigned int height = 480, width = 640, grid = 10;
+    const unsigned int updates = 1000000;
+
+    Map reference(height, width, grid, E_direction_major, E_double_cell);
+    Map float_map(height, width, grid, E_direction_major, E_float_cell);
+    Map fixed_map(height, width, grid, E_cell_major, E_fixed16_cell);
+
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<unsigned int> x_position(0, width-1), y_position(0, height-1);
+    std::normal_distribution<double> velocity(0.0, 8.0);
+
+    for(unsigned int i = 0; i < updates; ++i)
+    {
+        unsigned int x = x_position(generator), y = y_position(generator);
+        double dx = velocity(generator), dy = velocity(generator);
+        double angle = Map::CalcAngle(dy, dx);
+        reference.SetVelocityVector(x, y, dx, dy, angle);
+        float_map.SetVelocityVector(x, y, dx, dy, angle);
+        fixed_map.SetVelocityVector(x, y, dx, dy, angle);
+    }
+
+    const double angles[4] = {0, 90, 180, -90};
+    double float_max = 0, fixed_max = 0, float_sum = 0, fixed_sum = 0;
+    unsigned long cells = 0;
+
+    for(unsigned int y = 0; y < height; y += grid)
+    {
+        for(unsigned int x = 0; x < width; x += grid)
+        {
+            for(double angle : angles)
+            {
+                std::complex<double> expected = reference.GetVelocitVector(x, y, angle);
+                double float_error = std::abs(float_map.GetVelocitVector(x, y, angle) - expected);
+                double fixed_error = std::abs(fixed_map.GetVelocitVector(x, y, angle) - expected);
+                float_max = std::max(float_max, float_error);
+                fixed_max = std::max(fixed_max, fixed_error);
+                float_sum += float_error;
+                fixed_sum += fixed_error;
+                ++cells;
+            }
+        }
+    }
+
+    std::cout << "Cell size: double " << Map::CellSize(E_double_cell) << " B, float " << Map::CellSize(E_float_cell)
+              << " B, fixed16 " << Map::CellSize(E_fixed16_cell) << " B" << std::endl;
+    std::cout << "float:   max error " << float_max << " px, mean error " << float_sum/cells << " px" << std::endl;
+    std::cout << "fixed16: max error " << fixed_max << " px, mean error " << fixed_sum/cells << " px" << std::endl;
+
+    return(float_max < 1e-5 && fixed_max < 0.03 ? 0 : 1);
+}
@@ -0,0 +1,43 @@
+#include <iostream>
+#include <string>
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include "../modules/FramePreProcessor.hpp"
+
+/*
+ * Compares fused pre-processing with separate GaussianBlur, convertTo and cvtColor calls and measures both.
+ * Frame is read from the image given as the argument, random 4K frame is used without argument.
+ */
+int main(int argc, char **argv)
+{
+    cv::Mat frame;
+    if(argc > 1)
+        frame = cv::imread(argv[1]);
+    if(frame.empty())
+    {
+        frame.create(2160, 3840, CV_8UC3);
+        cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(256));
+    }
+
+    const int repeats = 20;
+    cv::Mat reference, reference_gray, fused, fused_gray;
+
+    int64 start = cv::getTickCount();
+    for(int i = 0; i < repeats; ++i)
+        FramePreProcessor::ProcessReference(frame, reference, &reference_gray);
+    double reference_time = double(cv::getTickCount() - start)/cv::getTickFrequency()/repeats;
+
+    start = cv::getTickCount();
+    for(int i = 0; i < repeats; ++i)
+        FramePreProcessor::Process(frame, fused, &fused_gray);
+    double fused_time = double(cv::getTickCount() - start)/cv::getTickFrequency()/repeats;
+
+    double blur_error = cv::norm(reference, fused, cv::NORM_INF);
+    double gray_error = cv::norm(reference_gray, fused_gray, cv::NORM_INF);
+
+    std::cout << "Frame " << frame.cols << "x" << frame.rows << std::endl;
+    std::cout << "separate: " << reference_time*1000 << " ms, fused: " << fused_time*1000 << " ms" << std::endl;
+    std::cout << "max error: pre-processed " << blur_error << ", gray " << gray_error << std::endl;
+
+    return(blur_error <= 2 && gray_error == 0 ? 0 : 1);
+}
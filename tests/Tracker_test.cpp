@@ -8,10 +8,13 @@
 #include "../modules/TrackerCore.hpp"
 #include "TrackerFiles.hpp"
 
-int main(void)
+int main(int argc, char **argv)
 {
     std::srand((unsigned int)(std::time(0))); // use current time as seed for random generator
 
+    //Option --headless processes the video without windows and keyboard pacing
+    const bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+
     TrackerFiles video;
     video.setFilePath("../video/");
     video.setVideoName("knihovna_auta");
@@ -23,7 +26,7 @@ int main(void)
     //Set and open video file
     std::cout << "Test of tracker core" << std::endl;
 
-    std::shared_ptr<VideoProcessor> test_processor = std::make_shared<VideoProcessor>();
+    std::shared_ptr<VideoProcessor> test_processor = std::make_shared<VideoProcessor>(!headless);
     std::shared_ptr<Map> test_map;
 
     if(!test_processor->OpenFile(video.getVideoName()))
@@ -47,16 +50,20 @@ int main(void)
     test_map = test_processor->GetMap();
     test_map->SetFileName(video.getMapName());
     test_map->LoadMap();
-    TrackerBase::SetMapPointer(test_map);
 
     TrackerCore test_tracker;
     test_tracker.SetVideoProcessor(test_processor);
     test_tracker.SetHiddenMask(test_processor->GetHiddenMask());
+    test_tracker.SetMap(test_map);
 
     int keyboard = 0;
+    unsigned long processed_frames = 0;
     while(test_processor->ReadNextFrame() && (char)keyboard != 'q' && (char)keyboard != 27)
     {
         test_tracker.TrackObjects();
+        ++processed_frames;
+        if(headless)
+            continue;
         test_tracker.DrawObjects();
         test_processor->DisplayOutput();
         test_map->PlotMap();
@@ -68,6 +75,7 @@ int main(void)
         }
     }
 
+    std::cout << "Processed frames: " << processed_frames << std::endl;
     test_map->SaveMap();
     return(0);
-}
\ No newline at end of file
+}
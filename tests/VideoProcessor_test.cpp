@@ -10,12 +10,15 @@ int main(int argc, char **argv)
 {
     std::srand((unsigned int)(std::time(0))); // use current time as seed for random generator
 
+    //Option --headless processes the video without windows and keyboard pacing
+    const bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+
     //Set and open video file
     std::cout << "Test of video processor" << std::endl;
     std::string video_file_name = "../video/MVI_5510.MOV";
     std::string background_file_name = "../video/MVI_5510.jpg";
 
-    VideoProcessor testProcessor;
+    VideoProcessor testProcessor(!headless);
     std::shared_ptr<Map> testMap;
     if(!testProcessor.OpenFile(video_file_name))
         return(1);
@@ -27,8 +30,12 @@ int main(int argc, char **argv)
 
     //Play video
     int keyboard = 0;
+    unsigned long processed_frames = 0;
     while(testProcessor.ReadNextFrame() && (char)keyboard != 'q' && (char)keyboard != 27)
     {
+        ++processed_frames;
+        if(headless)
+            continue;
         testProcessor.DisplayOutput();
         testMap->PlotMap();
         keyboard = cv::waitKey(30);
@@ -39,6 +46,7 @@ int main(int argc, char **argv)
         }
     }
 
+    std::cout << "Processed frames: " << processed_frames << std::endl;
 
     testMap->SaveMap();
     //std::cout << *testMap;
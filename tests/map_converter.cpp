@@ -0,0 +1,31 @@
+#include <iostream>
+#include <string>
+#include "../modules/Map.hpp"
+
+/*
+ * Converts map between the text format (suffix .txt) and the binary format (any other suffix).
+ * Format of input file is detected automatically.
+ */
+int main(int argc, char **argv)
+{
+    if(argc != 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " input_map output_map" << std::endl;
+        std::cerr << "Text format is used for files with suffix .txt, binary format otherwise." << std::endl;
+        return(1);
+    }
+
+    Map velocity_map(1, 1, 1);
+    velocity_map.SetFileName(argv[1]);
+    if(!velocity_map.LoadMap())
+        return(1);
+
+    velocity_map.SetFileName(argv[2]);
+    velocity_map.SaveMap();
+
+    std::cout << "Map " << argv[1] << " converted to " << argv[2] << std::endl;
+    if(velocity_map.GetTileSize() != 0)
+        std::cout << "Populated tiles: " << velocity_map.GetPopulatedTiles() << ", cells take "
+                  << velocity_map.GetMemoryUsage() << " B" << std::endl;
+    return(0);
+}
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <string>
+#include <fstream>
+#include <memory>
+#include <vector>
+#include <utility>
+#include <opencv2/core/core.hpp>
+#include "../modules/MapLearner.hpp"
+
+/*
+ * Learns velocity map from many recordings of the same camera in parallel. Existing map in the output file
+ * is loaded and the recordings are added to it.
+ */
+int main(int argc, char **argv)
+{
+    unsigned int threads = 0;
+    std::string bg_image, output_file;
+    MapCellEncoding encoding = E_double_cell;
+    unsigned int tile_size = 0;
+    std::vector<std::pair<std::string, std::string>> recordings;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        if(argument == "-j" && i + 1 < argc)
+            threads = (unsigned int)std::stoul(argv[++i]);
+        else if(argument == "-b" && i + 1 < argc)
+            bg_image = argv[++i];
+        else if(argument == "--compact-map")
+            encoding = E_fixed16_cell;
+        else if(argument == "--sparse-map")
+            tile_size = 16;
+        else if(output_file.empty())
+            output_file = argument;
+        else
+            recordings.push_back(std::make_pair(argument, bg_image));
+    }
+
+    if(recordings.empty())
+    {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] [--compact-map] [--sparse-map] output_map "
+                  << "[-b bg_image] video_file [video_file ...]" << std::endl;
+        std::cerr << "Background image is used for all following video files." << std::endl;
+        return(1);
+    }
+
+    MapLearner learner(threads);
+    learner.SetMapStorage(encoding, tile_size);
+    for(const auto &recording : recordings)
+        learner.AddRecording(recording.first, recording.second);
+
+    std::shared_ptr<Map> velocity_map;
+    if(std::ifstream(output_file).good())
+    {
+        velocity_map = std::make_shared<Map>(1, 1, 1);
+        velocity_map->SetFileName(output_file);
+        if(!velocity_map->LoadMap())
+            velocity_map = nullptr;
+    }
+
+    int64 start_ticks = cv::getTickCount();
+    velocity_map = learner.Learn(velocity_map);
+    double elapsed_time = double(cv::getTickCount() - start_ticks)/cv::getTickFrequency();
+
+    if(velocity_map == nullptr)
+    {
+        std::cerr << "No recording was learned!" << std::endl;
+        return(1);
+    }
+
+    velocity_map->SetFileName(output_file);
+    velocity_map->SaveMap();
+    std::cout << recordings.size() << " recordings learned into " << output_file << " in " << elapsed_time << " s" << std::endl;
+    return(0);
+}